@@ -0,0 +1,115 @@
+//***************************************************************************************
+// bench.cpp
+// Measurements of EVHEN white-box runtime
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_bench.
+//
+// wb_bench is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_bench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_bench.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "bench.h"
+#include "engine.h"
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif // WIN32
+
+namespace NWhiteBox
+{
+
+const int bench_repeats = 3;
+const uint64_t bench_warm_bytes = 4 * 1024 * 1024;		// per warm run
+const size_t bench_flush_size = 64 * 1024 * 1024;		// more than a last level cache
+
+std::string bench_result_t::Key() const
+{
+	char buf[64];
+	sprintf(buf, "/%u/%llu/%u/", rounds, (unsigned long long)size, threads);
+	return tables + buf + mode + "/" + kernel + (cold ? "/cold" : "/warm");
+}
+
+// Seconds with a high resolution (steady_clock of Visual Studio 2013 is not)
+static double wall_time()
+{
+#ifdef WIN32
+	LARGE_INTEGER c, f;
+	::QueryPerformanceCounter(&c);
+	::QueryPerformanceFrequency(&f);
+	return (double)c.QuadPart / f.QuadPart;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif // WIN32
+}
+
+static void flush_caches()
+{
+	static std::vector<uint8_t> junk(bench_flush_size);
+	for (size_t i = 0; i < junk.size(); i += 64)
+		++junk[i];
+}
+
+void measure(bench_fn_t const& fn, uint8_t* buf, uint64_t size, bool cold, bench_result_t& res)
+{
+	size_t count = (size_t)(size / block_size);
+	uint64_t reps = 1;
+	if (!cold)
+	{
+		reps = bench_warm_bytes / size;
+		if (!reps)
+			reps = 1;
+		fn(buf, count);
+	}
+
+	double best_cycles(0), best_time(0);
+	for (int i = 0; i < bench_repeats; ++i)
+	{
+		if (cold)
+			flush_caches();
+
+		double start_time = wall_time();
+		uint64_t start = __rdtsc();
+		for (uint64_t r = 0; r < reps; ++r)
+			fn(buf, count);
+		double cycles = (double)(__rdtsc() - start);
+		double time = wall_time() - start_time;
+
+		if (!i || cycles < best_cycles)
+		{
+			best_cycles = cycles;
+			best_time = time;
+		}
+	}
+
+	res.size = size;
+	res.cold = cold;
+	res.cycles_per_byte = best_cycles / ((double)size * reps);
+	res.blocks_per_sec = (best_time > 0) ? (double)count * reps / best_time : 0;
+}
+
+}
@@ -0,0 +1,62 @@
+//***************************************************************************************
+// bench.h
+// Measurements of EVHEN white-box runtime
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_bench.
+//
+// wb_bench is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_bench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_bench.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "stdtypes.h"
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace NWhiteBox
+{
+
+struct bench_result_t
+{
+	std::string	tables;				// "built-in" or a file of wb_creator
+	uint32_t	rounds;
+	std::string	mode;				// block, batched, macros, threads, ctr
+	std::string	kernel;
+	uint64_t	size;				// of a message in bytes
+	bool		cold;				// caches were flushed before every run
+	uint32_t	threads;
+	double		cycles_per_byte;
+	double		blocks_per_sec;
+
+	// Results of two runs are compared by keys
+	std::string Key() const;
+};
+
+// Encrypts count blocks of buf in place
+typedef std::function<void (uint8_t* buf, size_t count)> bench_fn_t;
+
+// The best of several runs. A warm run is preceded by an untimed one and repeats fn
+// over at least a few megabytes, a cold run evicts tables and data from caches first.
+void measure(bench_fn_t const& fn, uint8_t* buf, uint64_t size, bool cold, bench_result_t& res);
+
+}
+
+#endif // BENCH_H
@@ -0,0 +1,165 @@
+//***************************************************************************************
+// macros.h
+// Round macros of the first wb_sample, the baseline of benchmarks
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_bench.
+//
+// wb_bench is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_bench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_bench.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef MACROS_H
+#define MACROS_H
+
+#include "stdtypes.h"
+
+// encr_r/decr_r as they were in wb_sample/main.cpp, except that a round is given by a pointer
+// to its tables instead of the name of an array. Every output word is a separate XOR of
+// 16 lookups of 32-bit words.
+#define encr_r( bo, bi, t ) do{                                                     \
+    ((uint32_t*)bo)[0] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[0] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[5]])[0] ^                 \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[0] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[15]])[0] ^                \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[0] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[9]])[0] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[0] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[3]])[0] ^                 \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[0] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[13]])[0] ^                \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[0] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[7]])[0] ^                \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[0] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[1]])[0] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[0] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[11]])[0];                \
+    ((uint32_t*)bo)[1] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[1] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[5]])[1] ^                 \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[1] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[15]])[1] ^                \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[1] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[9]])[1] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[1] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[3]])[1] ^                 \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[1] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[13]])[1] ^                \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[1] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[7]])[1] ^                \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[1] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[1]])[1] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[1] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[11]])[1];                \
+    ((uint32_t*)bo)[2] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[2] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[5]])[2] ^                 \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[2] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[15]])[2] ^                \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[2] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[9]])[2] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[2] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[3]])[2] ^                 \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[2] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[13]])[2] ^                \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[2] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[7]])[2] ^                \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[2] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[1]])[2] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[2] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[11]])[2];                \
+    ((uint32_t*)bo)[3] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[3] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[5]])[3] ^                 \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[3] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[15]])[3] ^                \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[3] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[9]])[3] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[3] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[3]])[3] ^                 \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[3] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[13]])[3] ^                \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[3] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[7]])[3] ^                \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[3] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[1]])[3] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[3] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[11]])[3]; } while( 0 );
+
+#define decr_r( bo, bi, t )  do {                                                   \
+    ((uint32_t*)bo)[0] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[0] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[13]])[0] ^                \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[0] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[7]])[0] ^                 \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[0] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[1]])[0] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[0] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[11]])[0] ^                \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[0] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[5]])[0] ^                 \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[0] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[15]])[0] ^               \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[0] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[9]])[0] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[0] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[3]])[0];                 \
+    ((uint32_t*)bo)[1] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[1] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[13]])[1] ^                \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[1] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[7]])[1] ^                 \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[1] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[1]])[1] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[1] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[11]])[1] ^                \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[1] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[5]])[1] ^                 \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[1] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[15]])[1] ^               \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[1] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[9]])[1] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[1] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[3]])[1];                 \
+    ((uint32_t*)bo)[2] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[2] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[13]])[2] ^                \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[2] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[7]])[2] ^                 \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[2] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[1]])[2] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[2] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[11]])[2] ^                \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[2] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[5]])[2] ^                 \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[2] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[15]])[2] ^               \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[2] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[9]])[2] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[2] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[3]])[2];                 \
+    ((uint32_t*)bo)[3] = ((uint32_t*)(t)[0][((uint8_t*)bi)[0]])[3] ^                \
+                        ((uint32_t*)(t)[1][((uint8_t*)bi)[13]])[3] ^                \
+                        ((uint32_t*)(t)[2][((uint8_t*)bi)[10]])[3] ^                \
+                        ((uint32_t*)(t)[3][((uint8_t*)bi)[7]])[3] ^                 \
+                        ((uint32_t*)(t)[4][((uint8_t*)bi)[4]])[3] ^                 \
+                        ((uint32_t*)(t)[5][((uint8_t*)bi)[1]])[3] ^                 \
+                        ((uint32_t*)(t)[6][((uint8_t*)bi)[14]])[3] ^                \
+                        ((uint32_t*)(t)[7][((uint8_t*)bi)[11]])[3] ^                \
+                        ((uint32_t*)(t)[8][((uint8_t*)bi)[8]])[3] ^                 \
+                        ((uint32_t*)(t)[9][((uint8_t*)bi)[5]])[3] ^                 \
+                        ((uint32_t*)(t)[10][((uint8_t*)bi)[2]])[3] ^                \
+                        ((uint32_t*)(t)[11][((uint8_t*)bi)[15]])[3] ^               \
+                        ((uint32_t*)(t)[12][((uint8_t*)bi)[12]])[3] ^               \
+                        ((uint32_t*)(t)[13][((uint8_t*)bi)[9]])[3] ^                \
+                        ((uint32_t*)(t)[14][((uint8_t*)bi)[6]])[3] ^                \
+                        ((uint32_t*)(t)[15][((uint8_t*)bi)[3]])[3]; } while( 0 );
+
+#endif // MACROS_H
@@ -0,0 +1,252 @@
+//***************************************************************************************
+// main.cpp
+// Throughput of EVHEN white-box runtime kernels
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_bench.
+//
+// wb_bench is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_bench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_bench.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <vector>
+#include "stdtypes.h"
+#include "engine.h"
+#include "ctr.h"
+#include "bench.h"
+#include "report.h"
+#include "macros.h"
+#include "wb_decr_tbl.h"
+#include "wb_encr_tbl.h"
+
+using namespace NWhiteBox;
+
+static void usage()
+{
+	printf(
+		"wb_bench [options] [wb_encr_tbl.bin ...]\n"
+		"    -batch N          blocks in a batch of round-major mode (default %u)\n"
+		"    -min-size N       the smallest message in bytes (default 16)\n"
+		"    -max-size N       the largest message in bytes (default 1073741824)\n"
+		"    -threads N        threads of multithreaded modes (default one per CPU core)\n"
+		"    -cold, -warm      only cold or warm caches (default both)\n"
+		"    -json FILE        write results to FILE\n"
+		"wb_bench -compare BASE.json NEW.json [-threshold PERCENT]\n"
+		"    flags results which are slower than BASE by more than PERCENT (default 5)\n",
+		(uint32_t)default_batch_blocks);
+}
+
+// The first wb_sample: encr_r over all rounds of T-boxes block by block.
+// The final round of byte substitutions has no macro, it is done the same way as by the runtime.
+static void macros_encrypt(CTableSet const& t, uint8_t* buf, size_t count)
+{
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	for (size_t n = 0; n < count; ++n, buf += block_size)
+	{
+		uint32_t bi[4], bo[4];
+		memcpy(bi, buf, block_size);
+
+		for (uint32_t r = 0; r < rnum; ++r)
+		{
+			round_ptr_t rt = t.Round(r);
+			encr_r(bo, bi, rt);
+			memcpy(bi, bo, block_size);
+		}
+
+		if (final)
+		{
+			for (int j = 0; j < 16; ++j)
+				buf[j] = final[j][((uint8_t*)bi)[round_input_order[wb_encryption][j]]];
+		}
+		else
+			memcpy(buf, bi, block_size);
+	}
+}
+
+// ECB split between the threads of a pool by ranges of the batched mode
+static void threads_encrypt(CTableSet const& t, CThreadPool& pool, uint8_t* buf, size_t count)
+{
+	size_t per_thread = (count + pool.ThreadsNum() - 1) / pool.ThreadsNum();
+	pool.Run(pool.ThreadsNum(), [&](size_t i)
+	{
+		size_t first = i * per_thread;
+		if (first < count)
+		{
+			size_t n = (count - first < per_thread) ? count - first : per_thread;
+			encrypt_blocks_batched(t, buf + first * block_size, buf + first * block_size, n);
+		}
+	});
+}
+
+struct bench_mode_t
+{
+	char const*	mode;
+	char const*	kernel;
+	bench_fn_t	fn;
+	uint32_t	threads;
+};
+
+int main(int argc, char* argv[])
+{
+	size_t batch(default_batch_blocks);
+	uint64_t min_size(block_size), max_size(1ULL << 30);
+	uint32_t threads(0);
+	bool warm(true), cold(true);
+	char const* json(0);
+	std::vector<char const*> files;
+
+	try
+	{
+		if (argc >= 4 && !strcmp(argv[1], "-compare"))
+		{
+			double threshold = (argc >= 6 && !strcmp(argv[4], "-threshold")) ? atof(argv[5]) : 5.0;
+			std::vector<bench_result_t> base, cur;
+			read_report(argv[2], base);
+			read_report(argv[3], cur);
+			return compare_reports(base, cur, threshold) ? 2 : 0;
+		}
+
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg(argv[i]);
+			bool has_value = (i + 1 < argc);
+			if (arg == "-batch" && has_value)
+				batch = (size_t)atoi(argv[++i]);
+			else if (arg == "-min-size" && has_value)
+				min_size = strtoull(argv[++i], 0, 10);
+			else if (arg == "-max-size" && has_value)
+				max_size = strtoull(argv[++i], 0, 10);
+			else if (arg == "-threads" && has_value)
+				threads = (uint32_t)atoi(argv[++i]);
+			else if (arg == "-json" && has_value)
+				json = argv[++i];
+			else if (arg == "-cold")
+				warm = false;
+			else if (arg == "-warm")
+				cold = false;
+			else if (arg[0] == '-')
+			{
+				usage();
+				return 1;
+			}
+			else
+				files.push_back(argv[i]);
+		}
+
+		if (min_size < block_size)
+			min_size = block_size;
+		min_size -= min_size % block_size;
+		max_size -= max_size % block_size;
+		if (max_size < min_size)
+			max_size = min_size;
+
+		CThreadPool pool(threads);
+		std::vector<uint8_t> buf((size_t)max_size);
+		for (size_t i = 0; i < buf.size(); ++i)
+			buf[i] = (uint8_t)rand();
+
+		std::vector<bench_result_t> results;
+		size_t sets = files.empty() ? 1 : files.size();
+		for (size_t s = 0; s < sets; ++s)
+		{
+			CTableSet encr;
+			if (files.empty())
+				encr.Attach(wb_encryption, wb_encr_tbl, wb_encr_tbl_rnum, wb_encr_tbl_final);
+			else
+				encr.Load(files[s]);
+
+			std::vector<bench_mode_t> modes;
+			bench_mode_t m;
+			for (int k = wb_kernel_scalar; k < wb_kernels_count; ++k)
+			{
+				if (!kernel_supported((kernel_t)k))
+					continue;
+
+				m.kernel = kernel_name((kernel_t)k);
+				m.threads = 1;
+				m.mode = "block";
+				m.fn = [&encr, k](uint8_t* b, size_t n) { encrypt_blocks(encr, b, b, n, (kernel_t)k); };
+				modes.push_back(m);
+				m.mode = "batched";
+				m.fn = [&encr, k, batch](uint8_t* b, size_t n) { encrypt_blocks_batched(encr, b, b, n, batch, (kernel_t)k); };
+				modes.push_back(m);
+			}
+
+			m.kernel = "encr_r";
+			m.mode = "macros";
+			m.fn = [&encr](uint8_t* b, size_t n) { macros_encrypt(encr, b, n); };
+			modes.push_back(m);
+
+			m.kernel = kernel_name(best_kernel());
+			m.threads = pool.ThreadsNum();
+			m.mode = "threads";
+			m.fn = [&encr, &pool](uint8_t* b, size_t n) { threads_encrypt(encr, pool, b, n); };
+			modes.push_back(m);
+
+			static uint8_t const nonce[16] = { 0 };
+			m.mode = "ctr";
+			m.fn = [&encr, &pool](uint8_t* b, size_t n) { ctr_encrypt(encr, b, n * block_size, nonce, &pool); };
+			modes.push_back(m);
+
+			printf("%s: %u rounds\n", files.empty() ? "built-in" : files[s], encr.RoundsNum());
+			printf("%-8s %-10s %12s %5s %8s %12s %14s\n", "mode", "kernel", "size", "cache", "threads", "cycles/byte", "blocks/sec");
+
+			// 16 B, 256 B, 4 KB, ... and the largest size
+			for (uint64_t size = min_size; ; size = (size * 16 < max_size) ? size * 16 : max_size)
+			{
+				for (int c = 0; c < 2; ++c)
+				{
+					if ((c && !cold) || (!c && !warm))
+						continue;
+
+					for (size_t i = 0; i < modes.size(); ++i)
+					{
+						bench_result_t r;
+						r.tables = files.empty() ? "built-in" : files[s];
+						r.rounds = encr.RoundsNum();
+						r.mode = modes[i].mode;
+						r.kernel = modes[i].kernel;
+						r.threads = modes[i].threads;
+						measure(modes[i].fn, &buf[0], size, c != 0, r);
+						results.push_back(r);
+
+						printf("%-8s %-10s %12llu %5s %8u %12.2f %14.0f\n", r.mode.c_str(), r.kernel.c_str(),
+							(unsigned long long)r.size, c ? "cold" : "warm", r.threads, r.cycles_per_byte, r.blocks_per_sec);
+					}
+				}
+
+				if (size == max_size)
+					break;
+			}
+		}
+
+		if (json)
+			write_report(json, results);
+	}
+	catch (std::exception& e)
+	{
+		printf("%s", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+//***************************************************************************************
+// report.cpp
+// JSON reports of wb_bench and comparison of two reports
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_bench.
+//
+// wb_bench is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_bench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_bench.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <stdexcept>
+
+namespace NWhiteBox
+{
+
+void write_report(char const* fname, std::vector<bench_result_t> const& results)
+{
+	FILE* f = fopen(fname, "w");
+	if (!f)
+		throw std::runtime_error(std::string("ERROR: Can\'t open \'") + fname + "\' file!!!\n");
+
+	fprintf(f, "{\n\"results\": [\n");
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		bench_result_t const& r = results[i];
+		fprintf(f, "{ \"tables\": \"%s\", \"rounds\": %u, \"mode\": \"%s\", \"kernel\": \"%s\", "
+			"\"size\": %llu, \"cache\": \"%s\", \"threads\": %u, "
+			"\"cycles_per_byte\": %.4f, \"blocks_per_sec\": %.0f }%s\n",
+			r.tables.c_str(), r.rounds, r.mode.c_str(), r.kernel.c_str(), (unsigned long long)r.size,
+			r.cold ? "cold" : "warm", r.threads, r.cycles_per_byte, r.blocks_per_sec,
+			(i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(f, "]\n}\n");
+
+	if (fclose(f))
+		throw std::runtime_error(std::string("ERROR: Can\'t write \'") + fname + "\' file!!!\n");
+}
+
+// Values of a flat JSON object written by write_report
+static char const* json_value(std::string const& line, char const* key)
+{
+	std::string k = std::string("\"") + key + "\":";
+	std::string::size_type pos = line.find(k);
+	if (pos == std::string::npos)
+		throw std::runtime_error(std::string("ERROR: No \'") + key + "\' in a report!!!\n");
+	char const* p = line.c_str() + pos + k.size();
+	while (*p == ' ')
+		++p;
+	return p;
+}
+
+static std::string json_string(std::string const& line, char const* key)
+{
+	char const* p = json_value(line, key);
+	if (*p++ != '"')
+		throw std::runtime_error(std::string("ERROR: Illegal \'") + key + "\' in a report!!!\n");
+	char const* e = strchr(p, '"');
+	return std::string(p, e ? e : p + strlen(p));
+}
+
+static double json_number(std::string const& line, char const* key)
+{
+	return strtod(json_value(line, key), 0);
+}
+
+void read_report(char const* fname, std::vector<bench_result_t>& results)
+{
+	FILE* f = fopen(fname, "r");
+	if (!f)
+		throw std::runtime_error(std::string("ERROR: Can\'t open \'") + fname + "\' file!!!\n");
+
+	char buf[1024];
+	while (fgets(buf, sizeof(buf), f))
+	{
+		std::string line(buf);
+		if (line.find("\"mode\"") == std::string::npos)
+			continue;
+
+		bench_result_t r;
+		r.tables = json_string(line, "tables");
+		r.rounds = (uint32_t)json_number(line, "rounds");
+		r.mode = json_string(line, "mode");
+		r.kernel = json_string(line, "kernel");
+		r.size = (uint64_t)json_number(line, "size");
+		r.cold = json_string(line, "cache") == "cold";
+		r.threads = (uint32_t)json_number(line, "threads");
+		r.cycles_per_byte = json_number(line, "cycles_per_byte");
+		r.blocks_per_sec = json_number(line, "blocks_per_sec");
+		results.push_back(r);
+	}
+	fclose(f);
+}
+
+size_t compare_reports(std::vector<bench_result_t> const& base, std::vector<bench_result_t> const& cur, double threshold)
+{
+	std::map<std::string, bench_result_t const*> index;
+	for (size_t i = 0; i < base.size(); ++i)
+		index[base[i].Key()] = &base[i];
+
+	size_t regressions(0), matched(0);
+	for (size_t i = 0; i < cur.size(); ++i)
+	{
+		std::map<std::string, bench_result_t const*>::const_iterator it = index.find(cur[i].Key());
+		if (it == index.end() || it->second->cycles_per_byte <= 0)
+			continue;
+
+		++matched;
+		double change = (cur[i].cycles_per_byte / it->second->cycles_per_byte - 1) * 100;
+		bool slower = change > threshold;
+		if (slower)
+			++regressions;
+
+		printf("%-60s %10.2f %10.2f %+8.1f%%%s\n", cur[i].Key().c_str(), it->second->cycles_per_byte,
+			cur[i].cycles_per_byte, change, slower ? "  REGRESSION" : "");
+	}
+
+	printf("%u results compared, %u regressions (threshold %.1f%%)\n", (uint32_t)matched, (uint32_t)regressions, threshold);
+	return regressions;
+}
+
+}
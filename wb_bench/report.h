@@ -0,0 +1,42 @@
+//***************************************************************************************
+// report.h
+// JSON reports of wb_bench and comparison of two reports
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_bench.
+//
+// wb_bench is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_bench is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_bench.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "bench.h"
+
+namespace NWhiteBox
+{
+
+void write_report(char const* fname, std::vector<bench_result_t> const& results);
+// Reads a file of write_report (one result per line)
+void read_report(char const* fname, std::vector<bench_result_t>& results);
+// Prints the change of cycles/byte of every common result. Returns the number of results
+// which became slower by more than threshold percent.
+size_t compare_reports(std::vector<bench_result_t> const& base, std::vector<bench_result_t> const& cur, double threshold);
+
+}
+
+#endif // REPORT_H
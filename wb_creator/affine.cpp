@@ -0,0 +1,150 @@
+//***************************************************************************************
+// affine.cpp
+// Affine maps of bytes over GF(2)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_creator.
+//
+// wb_creator is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_creator.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "affine.h"
+#include "gf2exp8.h"
+#include "kernels.h"
+
+#ifdef WB_GFNI
+#include <immintrin.h>
+#endif // WB_GFNI
+
+namespace NGF2exp8
+{
+
+// Row i of the matrix is byte 7 - i of the operand
+uint64_t gfni_matrix(uint8_t const cols[8])
+{
+	// Bit i of byte k is M[i][k]. A transposition of the 8x8 bit matrix makes bytes rows,
+	// and the instruction wants row i in byte 7 - i
+	uint64_t x(0);
+	for (uint32_t k = 0; k < 8; ++k)
+		x |= (uint64_t)cols[k] << (k * 8);
+
+	uint64_t t;
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x ^= t ^ (t << 28);
+
+	uint64_t rows(0);
+	for (uint32_t i = 0; i < 8; ++i)
+		rows |= ((x >> (i * 8)) & 0xff) << ((7 - i) * 8);
+	return rows;
+}
+
+#ifdef WB_GFNI
+
+WB_TARGET_GFNI static void apply_gfni(uint8_t const cols[8], uint8_t c, uint8_t const* in, uint8_t* out, size_t count)
+{
+	// The constant of the instruction is an immediate, so c is added separately
+	__m128i m = _mm_set1_epi64x((long long)gfni_matrix(cols));
+	__m128i add = _mm_set1_epi8((char)c);
+	for (; count >= 16; count -= 16, in += 16, out += 16)
+	{
+		__m128i x = _mm_loadu_si128((__m128i const*)in);
+		x = _mm_xor_si128(_mm_gf2p8affine_epi64_epi8(x, m, 0), add);
+		_mm_storeu_si128((__m128i*)out, x);
+	}
+
+	if (count)
+	{
+		uint8_t buf[16] = { 0 };
+		memcpy(buf, in, count);
+		__m128i x = _mm_loadu_si128((__m128i const*)buf);
+		x = _mm_xor_si128(_mm_gf2p8affine_epi64_epi8(x, m, 0), add);
+		_mm_storeu_si128((__m128i*)buf, x);
+		memcpy(out, buf, count);
+	}
+}
+
+#endif // WB_GFNI
+
+CAffineMap::CAffineMap() : m_c(0)
+{
+	for (uint32_t i = 0; i < 8; ++i)
+		m_cols[i] = (uint8_t)(1 << i);
+}
+
+void CAffineMap::Mul(uint8_t a, uint8_t p)
+{
+	gmul_span(m_cols, a, m_cols, 8, p);
+	m_c = gmul_tab(a, m_c, p);
+}
+
+void CAffineMap::Xor(uint8_t c)
+{
+	m_c ^= c;
+}
+
+void CAffineMap::Then(CAffineMap const& g)
+{
+	for (uint32_t i = 0; i < 8; ++i)
+		m_cols[i] = g(m_cols[i]) ^ g.m_c;
+	m_c = g(m_c);
+}
+
+uint8_t CAffineMap::operator ()(uint8_t x) const
+{
+	uint8_t r(m_c);
+	for (uint32_t i = 0; x; ++i, x >>= 1)
+	{
+		if (x & 1)
+			r ^= m_cols[i];
+	}
+	return r;
+}
+
+void CAffineMap::CreateTable(uint8_t tbl[256]) const
+{
+	// f(x) = f(x without its lowest bit) ^ M * (lowest bit)
+	tbl[0] = m_c;
+	for (uint32_t x = 1; x < 256; ++x)
+	{
+		uint32_t i(0);
+		while (!(x & (1 << i)))
+			++i;
+		tbl[x] = tbl[x & (x - 1)] ^ m_cols[i];
+	}
+}
+
+void CAffineMap::Apply(uint8_t const* in, uint8_t* out, size_t count) const
+{
+#ifdef WB_GFNI
+	if (NWhiteBox::cpu_features() & NWhiteBox::wb_cpu_gfni)
+	{
+		apply_gfni(m_cols, m_c, in, out, count);
+		return;
+	}
+#endif // WB_GFNI
+
+	uint8_t tbl[256];
+	CreateTable(tbl);
+	for (size_t i = 0; i < count; ++i)
+		out[i] = tbl[in[i]];
+}
+
+}
@@ -0,0 +1,80 @@
+//***************************************************************************************
+// affine.h
+// Affine maps of bytes over GF(2)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_creator.
+//
+// wb_creator is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_creator.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef AFFINE_H
+#define AFFINE_H
+
+#include "stdtypes.h"
+#include <stddef.h>
+
+namespace NGF2exp8
+{
+
+// f(x) = M * x ^ c, where M is an 8x8 matrix over GF(2).
+// Multiplication by a constant is GF(2)-linear in every field, so a chain of mixes
+// followed by an additive mask is one such map and costs one lookup per byte.
+class CAffineMap
+{
+public:
+	CAffineMap();		// identity
+
+public:
+	// f = f(x) * a mod p
+	void Mul(uint8_t a, uint8_t p);
+
+	// f = f(x) ^ c
+	void Xor(uint8_t c);
+
+	// f = g(f(x))
+	void Then(CAffineMap const& g);
+
+	uint8_t operator ()(uint8_t x) const;
+
+	// tbl[x] = f(x)
+	void CreateTable(uint8_t tbl[256]) const;
+
+	// out[i] = f(in[i]) with GF2P8AFFINEQB if the CPU has it
+	void Apply(uint8_t const* in, uint8_t* out, size_t count) const;
+
+	uint8_t const* Cols() const
+	{
+		return m_cols;
+	}
+
+	uint8_t Const() const
+	{
+		return m_c;
+	}
+
+private:
+	uint8_t		m_cols[8];		// M * (1 << i)
+	uint8_t		m_c;
+};
+
+// The operand of GF2P8AFFINEQB for the matrix with the columns cols[i] = M * (1 << i)
+uint64_t gfni_matrix(uint8_t const cols[8]);
+
+}
+
+#endif // AFFINE_H
@@ -25,7 +25,22 @@
 #include "cipher.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "prng.h"
+#include "affine.h"
+#include "taskgraph.h"
+#include "engine.h"
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#ifndef WIN32
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#endif // WIN32
 
 
 namespace NWhiteBox
@@ -57,21 +72,415 @@ std::string val_to_str( int val )
     return buf;
 }
 
-std::string tbox_to_str( tbox_t const& item )
+// Decimal text of every byte value
+struct dec_bytes_t
 {
-    std::string s( "{ " );
-    for( int i = 0; i < sizeof( tbox_t ); ++i )
-    {     
-        s += val_to_str( item[i] );
-        if( i != sizeof( tbox_t ) )
-            s+= ", ";
-        else
-            s+= " ";
+    char        s[256][3];
+    uint8_t     len[256];
+};
+
+static constexpr dec_bytes_t make_dec_bytes()
+{
+    dec_bytes_t t = {};
+    for( uint32_t v = 0; v < 256; ++v )
+    {
+        uint32_t n = ( v >= 100 ) ? 3 : ( ( v >= 10 ) ? 2 : 1 );
+        for( uint32_t i = 0, d = v; i < n; ++i, d /= 10 )
+            t.s[v][n - 1 - i] = (char)( '0' + d % 10 );
+        t.len[v] = (uint8_t)n;
+    }
+    return t;
+}
+
+static constexpr dec_bytes_t dec_bytes = make_dec_bytes();
+
+inline char* put_byte( char* p, uint8_t v )
+{
+    memcpy( p, dec_bytes.s[v], 3 );
+    return p + dec_bytes.len[v];
+}
+
+inline char* put_str( char* p, char const* s, size_t len )
+{
+    memcpy( p, s, len );
+    return p + len;
+}
+
+template <size_t N>
+inline char* put_str( char* p, char const ( &s )[N] )
+{
+    return put_str( p, s, N - 1 );
+}
+
+// Text of a header file in parts: the prologue, every round of T-boxes and the epilogue.
+// Parts are independent, so they are formatted by different threads.
+typedef std::vector<char>   text_t;
+
+struct text_file_t
+{
+    std::string             fname;
+    std::string             tbl_name;
+    std::string             str_name;   // fname without extension
+    round_tbl_t const*      tables;
+    uint32_t                rnum;
+    uint32_t                tbox_rnum;
+    bool                    sparse;     // the last round is stored as byte substitutions (see tables.h)
+    std::vector<text_t>     parts;
+};
+
+static void init_text_file( text_file_t& f, std::string const& fname, std::string const& tbl_name,
+    CCipherCreator::tables_t const& tables, uint32_t rnum )
+{
+    f.fname = fname;
+    f.tbl_name = tbl_name;
+    f.str_name = fname.substr( 0, fname.find_first_of( '.' ) );
+    f.tables = (round_tbl_t const*)&tables[0];
+    f.rnum = rnum;
+    f.sparse = is_sparse_round( f.tables[rnum - 1] );
+    f.tbox_rnum = f.sparse ? rnum - 1 : rnum;
+    f.parts.resize( f.tbox_rnum + 2 );
+}
+
+static void text_of_round( text_t& text, std::string const& name, round_tbl_t const& tbl )
+{
+    // "{ 255, ... 255, }" of 16 bytes and a line break per entry
+    text.resize( name.size() + 32 + 16 * ( 8 + 256 * ( 5 + sizeof( tbox_t ) * 5 ) ) );
+    char* p = &text[0];
+
+    p = put_str( p, "const tbox_t " );
+    p = put_str( p, name.c_str(), name.size() );
+    p = put_str( p, "[16][256] = { \n" );
+
+    for( uint32_t j = 0; j < 16; ++j )
+    {
+        p = put_str( p, "{ " );
+        for( uint32_t k = 0; k < 256; ++k )
+        {
+            p = put_str( p, "{ " );
+            for( uint32_t cnt = 0; cnt < sizeof( tbox_t ); ++cnt )
+            {
+                p = put_byte( p, tbl[j][k][cnt] );
+                p = put_str( p, ", " );
+            }
+            p = put_str( p, "}" );
+            p = ( k != 255 ) ? put_str( p, ",\n" ) : put_str( p, "\n" );
+        }
+        p = ( j != 15 ) ? put_str( p, "},\n" ) : put_str( p, "}\n" );
+    }
+    p = put_str( p, "};\n" );
+
+    text.resize( p - &text[0] );
+}
+
+static void text_of_sbox( text_t& text, std::string const& name, round_sbox_t const& sbox )
+{
+    text.resize( name.size() + 32 + 16 * ( 8 + 256 * 5 ) );
+    char* p = &text[0];
+
+    p = put_str( p, "const uint8_t " );
+    p = put_str( p, name.c_str(), name.size() );
+    p = put_str( p, "[16][256] = { \n" );
+
+    for( uint32_t j = 0; j < 16; ++j )
+    {
+        p = put_str( p, "{ " );
+        for( uint32_t i = 0; i < 256; ++i )
+        {
+            p = put_byte( p, sbox[j][i] );
+            if( i != 255 )
+                p = ( i % 16 != 15 ) ? put_str( p, ", " ) : put_str( p, ",\n" );
+            else
+                p = put_str( p, " " );
+        }
+        p = put_str( p, "}" );
+        p = ( j != 15 ) ? put_str( p, ",\n" ) : put_str( p, "\n" );
+    }
+    p = put_str( p, "};\n" );
+
+    text.resize( p - &text[0] );
+}
+
+static void append( text_t& text, std::string const& s )
+{
+    text.insert( text.end(), s.begin(), s.end() );
+}
+
+static void text_prologue( text_t& text, std::string const& str_name )
+{
+    std::string s( "/*****************************************************************************************\n" );
+    s += "Chaotically generated EVHEN white-box tables\n\n";
+    s += license;
+    s += "*****************************************************************************************/\n\n\n";
+    s += "#include \"stdtypes.h\"\n#ifndef " + str_name + "_H\n#define " + str_name + "_H\n\n";
+    append( text, s );
+}
+
+// The last round as byte substitutions if sbox is not 0, and the index of rounds
+static void text_epilogue( text_t& text, std::string const& tbl_name, std::string const& str_name, uint32_t rnum,
+    round_sbox_t const* sbox )
+{
+    uint32_t tbox_rnum = sbox ? rnum - 1 : rnum;
+    std::string final_name( "0" );
+    if( sbox )
+    {
+        final_name = tbl_name + "_" + val_to_str( rnum - 1 );
+        text_of_sbox( text, final_name, *sbox );
+    }
+
+    // Index of rounds, so a runtime can load any number of rounds without editing the code.
+    // _rnum counts all rounds, the index holds rounds of T-boxes only if _final is not 0.
+    std::string s( "\nconst tbox_t (* const " + tbl_name + "[])[256] = { " );
+    for( uint32_t i = 0; i < tbox_rnum; ++i )
+    {
+        s += tbl_name + "_" + val_to_str( i );
+        s += ( i != tbox_rnum - 1 ) ? ", " : " ";
+    }
+    s += "};\n";
+    s += "const uint8_t (* const " + tbl_name + "_final)[256] = " + final_name + ";\n";
+    s += "const uint32_t " + tbl_name + "_rnum = " + val_to_str( rnum ) + ";\n";
+    s += "\n#endif // " + str_name + "_H\n";
+    append( text, s );
+}
+
+static void text_part( text_file_t& f, size_t part )
+{
+    text_t& text = f.parts[part];
+
+    if( !part )
+    {
+        text_prologue( text, f.str_name );
+        return;
+    }
+
+    if( part <= f.tbox_rnum )
+    {
+        uint32_t i = (uint32_t)( part - 1 );
+        text_of_round( text, f.tbl_name + "_" + val_to_str( i ), f.tables[i] );
+        return;
+    }
+
+    round_sbox_t sbox;
+    if( f.sparse )
+        compress_round( f.tables[f.rnum - 1], sbox );
+    text_epilogue( text, f.tbl_name, f.str_name, f.rnum, f.sparse ? &sbox : 0 );
+}
+
+// All parts go to the file at once: one writev where it exists. WriteFileGather of Windows takes
+// only unbuffered pages, so there the parts are joined with the line breaks of a text file
+// (as the text mode of earlier versions wrote them) and the buffer goes to the file in one write.
+static void write_text_file( text_file_t const& f )
+{
+#ifdef WIN32
+    size_t size( 0 );
+    for( size_t i = 0; i < f.parts.size(); ++i )
+        size += f.parts[i].size() + std::count( f.parts[i].begin(), f.parts[i].end(), '\n' );
+
+    text_t buf;
+    buf.reserve( size );
+    for( size_t i = 0; i < f.parts.size(); ++i )
+    {
+        for( text_t::const_iterator it = f.parts[i].begin(); it != f.parts[i].end(); ++it )
+        {
+            if( *it == '\n' )
+                buf.push_back( '\r' );
+            buf.push_back( *it );
+        }
+    }
+
+    FILE* file;
+    errno_t err = fopen_s( &file, f.fname.c_str(), "wb" );
+    if( err != 0 )
+        throw std::runtime_error( std::string( "ERROR: Can\'t open \'" ) + f.fname + "\' file!!!\n" );
+
+    bool ok = buf.empty() || fwrite( &buf[0], 1, buf.size(), file ) == buf.size();
+    ok = !fclose( file ) && ok;
+#else
+    int fd = ::open( f.fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd < 0 )
+        throw std::runtime_error( std::string( "ERROR: Can\'t open \'" ) + f.fname + "\' file!!!\n" );
+
+    std::vector<struct iovec> v;
+    for( size_t i = 0; i < f.parts.size(); ++i )
+    {
+        if( f.parts[i].empty() )
+            continue;
+        struct iovec io;
+        io.iov_base = (void*)&f.parts[i][0];
+        io.iov_len = f.parts[i].size();
+        v.push_back( io );
+    }
+
+    // writev may write a part of the data or take IOV_MAX vectors at most
+    bool ok( true );
+    for( size_t i = 0; i < v.size() && ok; )
+    {
+        int n = (int)( ( v.size() - i < IOV_MAX ) ? v.size() - i : IOV_MAX );
+        ssize_t w = ::writev( fd, &v[i], n );
+        if( w < 0 )
+        {
+            ok = errno == EINTR;
+            continue;
+        }
+        for( ; i < v.size() && (size_t)w >= v[i].iov_len; ++i )
+            w -= v[i].iov_len;
+        if( w )
+        {
+            v[i].iov_base = (char*)v[i].iov_base + w;
+            v[i].iov_len -= w;
+        }
+    }
+    ok = !::close( fd ) && ok;
+#endif // WIN32
+
+    if( !ok )
+        throw std::runtime_error( std::string( "ERROR: Can\'t write \'" ) + f.fname + "\' file!!!\n" );
+}
+
+// Header, round descriptors and padding up to the first round of a binary file (see tblformat.h).
+// The checksum is left zero.
+static void init_tbl_head( std::vector<uint8_t>& head, direction_t dir, uint32_t rnum, bool sparse )
+{
+    uint64_t data_offset = tbl_align( sizeof( tbl_file_header_t ) + rnum * sizeof( tbl_round_desc_t ) );
+    size_t tbox_size = ( sparse ? rnum - 1 : rnum ) * sizeof( round_tbl_t );
+    head.assign( (size_t)data_offset, 0 );
+
+    tbl_round_desc_t* desc = (tbl_round_desc_t*)&head[sizeof( tbl_file_header_t )];
+    for( uint32_t i = 0; i < rnum; ++i )
+    {
+        desc[i].kind = tbl_round_tboxes;
+        desc[i].size = sizeof( round_tbl_t );
+        desc[i].offset = data_offset + i * (uint64_t)sizeof( round_tbl_t );
+    }
+    if( sparse )
+    {
+        desc[rnum - 1].kind = tbl_round_sbox;
+        desc[rnum - 1].size = sizeof( round_sbox_t );
     }
-    s += "}";
-    return s;
+
+    tbl_file_header_t* h = (tbl_file_header_t*)&head[0];
+    memcpy( h->magic, tbl_file_magic, sizeof( tbl_file_magic ) );
+    h->version = tbl_file_version;
+    h->header_size = sizeof( tbl_file_header_t );
+    h->direction = dir;
+    h->rounds_num = rnum;
+    h->block_size = 16;
+    h->alignment = tbl_file_alignment;
+    h->data_offset = data_offset;
+    h->file_size = data_offset + tbox_size + ( sparse ? sizeof( round_sbox_t ) : 0 );
 }
 
+static void init_key_header( key_file_header_t& h, uint32_t rnum, uint32_t flags, uint64_t checksum )
+{
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, key_file_magic, sizeof( key_file_magic ) );
+    h.version = key_file_version;
+    h.header_size = sizeof( key_file_header_t );
+    h.direction = wb_decryption;
+    h.rounds_num = rnum;
+    h.round_size = key_round_size( flags );
+    h.flags = flags;
+    h.file_size = sizeof( key_file_header_t ) + rnum * (uint64_t)h.round_size;
+    h.checksum = checksum;
+}
+
+// fseek to an offset of 64 bits: long has 32 bits on Windows, and off_t of 32-bit POSIX
+// builds without _FILE_OFFSET_BITS=64 can't take offsets past 2 GB either
+static int seek_file( FILE* f, uint64_t offset )
+{
+#ifdef WIN32
+    return _fseeki64( f, (__int64)offset, SEEK_SET );
+#else
+    if( (uint64_t)(off_t)offset != offset )
+        return -1;
+    return fseeko( f, (off_t)offset, SEEK_SET );
+#endif // WIN32
+}
+
+// A file of CCipherCreator::Stream. Data goes to the file a round at a time, the headers
+// of binary files are written over their place at the end. A file without a name is skipped.
+class CStreamFile
+{
+public:
+    CStreamFile() : m_f( 0 )
+    {
+    }
+
+    ~CStreamFile()
+    {
+        if( m_f )
+            fclose( m_f );
+    }
+
+    void Open( std::string const& fname, char const* mode )
+    {
+        m_fname = fname;
+        if( fname.empty() )
+            return;
+        if( fopen_s( &m_f, fname.c_str(), mode ) != 0 )
+        {
+            m_f = 0;
+            throw std::runtime_error( std::string( "ERROR: Can\'t open \'" ) + fname + "\' file!!!\n" );
+        }
+    }
+
+    bool IsOpen() const
+    {
+        return m_f != 0;
+    }
+
+    void Write( void const* data, size_t size )
+    {
+        if( m_f && size && fwrite( data, 1, size, m_f ) != size )
+            Fail();
+    }
+
+    void Write( text_t const& text )
+    {
+        Write( text.empty() ? 0 : &text[0], text.size() );
+    }
+
+    // tbl_checksum of the bytes from offset up to the end of the file
+    uint64_t Checksum( uint64_t offset, uint64_t h )
+    {
+        std::vector<uint8_t> buf( sizeof( round_tbl_t ) );
+        if( fflush( m_f ) || seek_file( m_f, offset ) )
+            Fail();
+        for( size_t n; ( n = fread( &buf[0], 1, buf.size(), m_f ) ) != 0; )
+            h = tbl_checksum( &buf[0], n, h );
+        if( ferror( m_f ) )
+            Fail();
+        return h;
+    }
+
+    void WriteHead( void const* data, size_t size )
+    {
+        if( m_f && seek_file( m_f, 0 ) )
+            Fail();
+        Write( data, size );
+    }
+
+    void Close()
+    {
+        FILE* f = m_f;
+        m_f = 0;
+        if( f && fclose( f ) )
+            Fail();
+    }
+
+private:
+    CStreamFile( CStreamFile const& );
+    CStreamFile const& operator =( CStreamFile const& );
+
+    void Fail()
+    {
+        throw std::runtime_error( std::string( "ERROR: Can\'t write \'" ) + m_fname + "\' file!!!\n" );
+    }
+
+private:
+    FILE*           m_f;
+    std::string     m_fname;
+};
+
 void show_matrix(const NGFMatrix::CMatrix &m)
 {
 	if (!m.IsInit())
@@ -99,7 +508,7 @@ void show_matrix(const NGFMatrix::CCauchyMatrix &m)
 // 
 
 CCipherCreator::CCipherCreator( uint32_t rnum, uint32_t min_mix_count, uint32_t max_mix_count ) : m_rnum( rnum ), 
-m_min_mix_count( min_mix_count ), m_max_mix_count( max_mix_count )
+m_min_mix_count( min_mix_count ), m_max_mix_count( max_mix_count ), m_seeded( false ), m_key_flags( key_flag_sboxes )
 {
 
 }
@@ -109,169 +518,680 @@ CCipherCreator::~CCipherCreator()
 
 }
 
-void CCipherCreator::Init()
+void CCipherCreator::SetSeed( uint8_t const seed[32] )
+{
+    m_prng.SetSeed( seed );
+    m_seeded = true;
+}
+
+void CCipherCreator::SetKeyFlags( uint32_t flags )
+{
+    m_key_flags = flags;
+}
+
+void CCipherCreator::Init( CThreadPool* pool )
 {
     if( m_rnum < 2 )
         throw std::runtime_error( "ERROR: Rounds number must be equal or greater than 2!!!" );
 
-    // Create white-box lookup tables for every round
-    CRound rnd( m_min_mix_count, m_max_mix_count );
-    rnd.Init();
-    m_rounds.push_back( rnd );
+    // Without a master seed the key comes from a random one, so the order in which
+    // the tasks below take random numbers doesn't matter
+    if( !m_seeded )
+        m_prng.NewSeed();
+
+    m_rounds.clear();
+    m_anti_rounds.clear();
+    m_encr_tables.clear();
+    m_decr_tables.clear();
+    m_rounds.reserve( m_rnum );
+    m_anti_rounds.reserve( m_rnum );
+    for( uint32_t i = 0; i < m_rnum; ++i )
+    {
+        m_rounds.emplace_back( m_min_mix_count, m_max_mix_count, false, i == m_rnum - 1 );
+        m_rounds.back().SetContext( &m_prng, i );
+        m_anti_rounds.emplace_back( m_min_mix_count, m_max_mix_count, true, i == m_rnum - 1 );
+        m_anti_rounds.back().SetContext( &m_prng, i );
+    }
+
+    // S-boxes, MDS matrices and mixes of all rounds are independent. The s-boxes of a round
+    // are encoded with the mixes of the previous one, and a decryption round takes
+    // the inverse s-boxes of an encryption round and the MDS matrix of the round before it.
+    CTaskGraph g;
+    std::vector<CTaskGraph::id_t> sboxes( m_rnum ), mds( m_rnum ), mixes( m_rnum ), anti_mixes( m_rnum );
+    std::vector<CRound::mix_t> const no_mixes;
+    NGFPoly::CPoly const no_mask;
+
+    for( uint32_t i = 0; i < m_rnum; ++i )
+    {
+        CRound* r = &m_rounds[i];
+        sboxes[i] = g.Add( [r]() { r->CreateSboxes(); } );
+        mds[i] = g.Add( [r]() { r->CreateMdsMatrix(); } );
+        if( !r->IsLast() )
+            mixes[i] = g.Add( [r]() { r->CreateMixes(); } );
+
+        CRound const* prev = i ? &m_rounds[i - 1] : 0;
+        CTaskGraph::id_t apply = g.Add( [r, prev, &no_mixes, &no_mask]()
+            { r->ApplyPrevMixes( prev ? prev->GetMixes() : no_mixes, prev ? prev->GetAdditiveMask() : no_mask ); } );
+        g.Depends( apply, sboxes[i] );
+        if( i )
+            g.Depends( apply, mixes[i - 1] );
+    }
+
+    for( uint32_t k = 0; k < m_rnum; ++k )
+    {
+        CRound* r = &m_anti_rounds[k];
+        if( !r->IsLast() )
+            anti_mixes[k] = g.Add( [r]() { r->CreateMixes(); } );
+    }
 
-    for( uint32_t i = 1; i < m_rnum - 1; ++i )
+    for( uint32_t k = 0; k < m_rnum; ++k )
     {
-        rnd.Clear();
-		rnd.Init(m_rounds[i - 1].GetMixes(), m_rounds[i - 1].GetAdditiveMask());
-        m_rounds.push_back( rnd );
+        // Decryption round k undoes encryption round i. The last one has no MDS matrix
+        uint32_t i = m_rnum - 1 - k;
+        CRound* r = &m_anti_rounds[k];
+        CRound const* src = &m_rounds[i];
+        CRound const* mds_src = &m_rounds[i ? i - 1 : 0];
+        bool last = r->IsLast();
+
+        CTaskGraph::id_t set = g.Add( [r, src, mds_src, last]()
+        {
+            CRound::s_boxes_t s_boxes_inv;
+            InverseSboxes( src->GetClearSboxes(), s_boxes_inv );
+            r->SetSboxes( s_boxes_inv );
+            r->SetSboxChaos( src->GetSboxChaos() );
+            r->SetMdsMatrix( last ? NGFMatrix::CCauchyMatrix() : mds_src->GetMdsMatrix(), mds_src->GetIrreduciblePoly() );
+        } );
+        g.Depends( set, sboxes[i] );
+        g.Depends( set, mds[i ? i - 1 : 0] );
+
+        CRound const* prev = k ? &m_anti_rounds[k - 1] : 0;
+        CTaskGraph::id_t apply = g.Add( [r, prev, &no_mixes, &no_mask]()
+            { r->ApplyPrevMixes( prev ? prev->GetMixes() : no_mixes, prev ? prev->GetAdditiveMask() : no_mask ); } );
+        g.Depends( apply, set );
+        if( k )
+            g.Depends( apply, anti_mixes[k - 1] );
     }
 
-    CRound last( m_min_mix_count, m_max_mix_count, false, true );
-	last.Init(m_rounds[m_rnum - 2].GetMixes(), m_rounds[m_rnum - 2].GetAdditiveMask());
-    m_rounds.push_back( last );
+    g.Run( pool );
+}
+
+void CCipherCreator::Reencode( CCipherCreator const& master, CThreadPool* pool )
+{
+    if( master.m_rounds.empty() || master.m_rnum != m_rnum )
+        throw std::runtime_error( "ERROR: Master key is not initialized or has another number of rounds!!!\n" );
 
-	// Create white-box inverse lookup tables (decryption lookup tables) for every round
-    rnd.Clear();
-    //rnd.SetMinMixesCount( 0 );	// uncomment for debugging
-    //rnd.SetMaxMixesCount( 0 );	// uncomment for debugging
-    rnd.SetDecryption( true );
-    CRound::s_boxes_t   s_boxes_inv;
-    InverseSboxes( last.GetClearSboxes(), s_boxes_inv );
-	rnd.Init(s_boxes_inv, m_rounds[m_rnum - 2].GetMdsMatrix(),
-        m_rounds[m_rnum - 2].GetIrreduciblePoly() );
-    m_anti_rounds.push_back( rnd );
+    if( !m_seeded )
+        m_prng.NewSeed();
 
-    for( uint32_t i = m_rnum - 2; i >= 1; --i )
+    m_rounds.clear();
+    m_anti_rounds.clear();
+    m_encr_tables.clear();
+    m_decr_tables.clear();
+    m_rounds.reserve( m_rnum );
+    m_anti_rounds.reserve( m_rnum );
+    for( uint32_t i = 0; i < m_rnum; ++i )
     {
-        rnd.Clear();     
-        InverseSboxes( m_rounds[i].GetClearSboxes(), s_boxes_inv );
-		rnd.Init(s_boxes_inv, m_rounds[i - 1].GetMdsMatrix(),
-			m_rounds[i - 1].GetIrreduciblePoly(), m_anti_rounds[m_anti_rounds.size() - 1].GetMixes(), 
-			m_anti_rounds[m_anti_rounds.size() - 1].GetAdditiveMask());
-        m_anti_rounds.push_back( rnd );
+        m_rounds.emplace_back( m_min_mix_count, m_max_mix_count, false, i == m_rnum - 1 );
+        m_rounds.back().SetContext( &m_prng, i );
+        m_anti_rounds.emplace_back( m_min_mix_count, m_max_mix_count, true, i == m_rnum - 1 );
+        m_anti_rounds.back().SetContext( &m_prng, i );
     }
 
-    last.Clear();
-    last.SetDecryption( true );
-	NGFMatrix::CCauchyMatrix m;
-    InverseSboxes( m_rounds[0].GetClearSboxes(), s_boxes_inv );
-	last.Init(s_boxes_inv, m, m_rounds[0].GetIrreduciblePoly(), m_anti_rounds[m_anti_rounds.size() - 1].GetMixes(), 
-		m_anti_rounds[m_anti_rounds.size() - 1].GetAdditiveMask());
-    m_anti_rounds.push_back( last );
+    // Only the mixes are new, so a round waits for the mixes of the previous one only
+    std::vector<CRound::mix_t> const no_mixes;
+    NGFPoly::CPoly const no_mask;
+
+    auto mixes = [&]( size_t i )
+    {
+        bool decr = i >= m_rnum;
+        uint32_t index = (uint32_t)( i % m_rnum );
+        CRound& r = ( decr ? m_anti_rounds : m_rounds )[index];
+        CRound const& src = ( decr ? master.m_anti_rounds : master.m_rounds )[index];
+
+        r.SetSboxes( src.GetClearSboxes() );
+        r.SetSboxChaos( src.GetSboxChaos() );
+        r.SetMdsMatrix( src.GetMdsMatrix(), src.GetIrreduciblePoly() );
+        if( !r.IsLast() )
+            r.CreateMixes();
+    };
+    auto apply = [&]( size_t i )
+    {
+        bool decr = i >= m_rnum;
+        uint32_t index = (uint32_t)( i % m_rnum );
+        std::vector<CRound>& rounds = decr ? m_anti_rounds : m_rounds;
+        CRound const* prev = index ? &rounds[index - 1] : 0;
+        rounds[index].ApplyPrevMixes( prev ? prev->GetMixes() : no_mixes, prev ? prev->GetAdditiveMask() : no_mask );
+    };
+
+    if( pool )
+    {
+        pool->Run( 2 * m_rnum, mixes );
+        pool->Run( 2 * m_rnum, apply );
+    }
+    else
+    {
+        for( size_t i = 0; i < 2 * m_rnum; ++i )
+            mixes( i );
+        for( size_t i = 0; i < 2 * m_rnum; ++i )
+            apply( i );
+    }
 }
 
-void CCipherCreator::Flash( std::string const& fname_encr, std::string const& fname_decr )
+void CCipherCreator::CreateDevices( uint32_t first, uint32_t count, device_t const& device, CThreadPool* pool )
 {
-    FlashOneFile( fname_encr, "wb_encr_tbl", m_rounds );
-    FlashOneFile( fname_decr, "wb_decr_tbl", m_anti_rounds );
+    // A device is cheap, so every thread re-encodes whole devices one after another
+    auto task = [&]( size_t i )
+    {
+        uint32_t k = first + (uint32_t)i;
+        uint8_t seed[32];
+        m_prng.DeriveSeed( k, seed, NPrng::rnd_devices );
+
+        CCipherCreator c( m_rnum, m_min_mix_count, m_max_mix_count );
+        c.SetSeed( seed );
+        c.SetKeyFlags( m_key_flags );
+        c.Reencode( *this );
+        c.CreateTables();
+        device( k, c );
+    };
+
+    if( pool )
+        pool->Run( count, task );
+    else
+        for( size_t i = 0; i < count; ++i )
+            task( i );
 }
 
-void CCipherCreator::FlashOneFile( std::string const& fname, std::string const& tbl_name, std::vector<CRound> const& rounds )
+void CCipherCreator::Stream( stream_files_t const& files, CThreadPool* pool )
 {
-    FILE* f;
-    errno_t err = fopen_s( &f, fname.c_str(), "w" );  
-    if( err != 0 )
-        throw std::runtime_error( std::string( "ERROR: Can\'t open \'" ) + fname + "\' file!!!\n" );
+    if( m_rnum < 2 )
+        throw std::runtime_error( "ERROR: Rounds number must be equal or greater than 2!!!" );
 
-    std::string::size_type pos = fname.find_first_of( '.' );
-    std::string str_name;
-    for( std::string::size_type i = 0; i < pos; ++i )
-        str_name += fname[i];
+    if( !m_seeded )
+        m_prng.NewSeed();
 
-    std::string str_wb( "/*****************************************************************************************\n" );
-    str_wb += "Chaotically generated EVHEN white-box tables\n\n";
-	str_wb += license;
-    str_wb += "*****************************************************************************************/\n\n\n";
-    str_wb += "#include \"stdtypes.h\"\n#ifndef " + str_name + "_H\n#define " + str_name + "_H\n\n";
+    m_rounds.clear();
+    m_anti_rounds.clear();
+    m_encr_tables.clear();
+    m_decr_tables.clear();
 
-    // Convert rounds to T-boxes
-    for( uint32_t i = 0; i < m_rnum; ++i )
+    auto run = [pool]( size_t count, CThreadPool::task_t const& task )
     {
-        str_wb += "const tbox_t " + tbl_name + "_" + val_to_str( i ) + "[16][256] = { \n";
+        if( pool )
+            pool->Run( count, task );
+        else
+            for( size_t i = 0; i < count; ++i )
+                task( i );
+    };
 
-		NGFPoly::CPoly additive_masks_sum;
-		additive_masks_sum.reserve(16);
-		additive_masks_sum.volatile_size(false);
+    // Index 0 is encryption, 1 is decryption
+    std::string const tbl_name[2] = { "wb_encr_tbl", "wb_decr_tbl" };
+    std::string const str_name[2] = { files.encr_header.substr( 0, files.encr_header.find_first_of( '.' ) ),
+        files.decr_header.substr( 0, files.decr_header.find_first_of( '.' ) ) };
+    CStreamFile text_file[2], bin_file[2], key_file;
+    text_file[0].Open( files.encr_header, "w" );
+    text_file[1].Open( files.decr_header, "w" );
+    bin_file[0].Open( files.encr_binary, "w+b" );
+    bin_file[1].Open( files.decr_binary, "w+b" );
+    key_file.Open( files.decr_key, "wb" );
 
-		NGFMatrix::CMatrix inv_mds;
-		const NGFMatrix::CMatrix *mds(0);
+    // Prologues and the place of the headers
+    std::vector<uint8_t> head;
+    init_tbl_head( head, wb_encryption, m_rnum, false );
+    std::vector<uint8_t> const zeros( head.size() > sizeof( key_file_header_t ) ? head.size() : sizeof( key_file_header_t ), 0 );
+    for( int d = 0; d < 2; ++d )
+    {
+        text_t text;
+        text_prologue( text, str_name[d] );
+        text_file[d].Write( text );
+        bin_file[d].Write( &zeros[0], head.size() );
+    }
+    key_file.Write( &zeros[0], sizeof( key_file_header_t ) );
+    uint64_t key_checksum = tbl_checksum( 0, 0 );
 
-		if (!rounds[i].IsLast())
-		{
-			if (rounds[i].IsDecyption())
-			{
-				rounds[i].GetMdsMatrix().Inverse(inv_mds);
-				mds = &inv_mds;
-			}
-			else
-			{
-				mds = &rounds[i].GetMdsMatrix().GetNativeMatrix();
-			}
-		}
+    // A window of rounds of both directions is built at a time, a round per thread.
+    // Only the last rounds of the window stay for the mixes and the masks of the next one.
+    uint32_t const window = pool ? pool->ThreadsNum() : 1;
+    std::vector<CRound> rounds[2], prev[2];
+    std::vector<uint8_t> tables( 2 * window * sizeof( round_tbl_t ) );
+    std::vector<key_round_t> keys( window );
+    std::vector<uint8_t> key_sboxes( window * sizeof( round_sbox_t ) );
+    round_sbox_t* clear = ( m_key_flags & key_flag_sboxes ) ? (round_sbox_t*)&key_sboxes[0] : 0;
+    std::vector<text_t> texts( 2 * window );
+    bool sparse[2] = { false, false };
+    round_sbox_t final_sbox[2];
+    std::vector<CRound::mix_t> const no_mixes;
+    NGFPoly::CPoly const no_mask;
 
-        for( uint32_t j = 0; j < 16; ++j )
-        {   
-            str_wb += "{ ";
+    for( uint32_t first = 0; first < m_rnum; first += window )
+    {
+        uint32_t n = ( m_rnum - first < window ) ? m_rnum - first : window;
+        for( int d = 0; d < 2; ++d )
+        {
+            prev[d].clear();
+            if( !rounds[d].empty() )
+                prev[d].push_back( std::move( rounds[d].back() ) );
+            rounds[d].clear();
+            for( uint32_t i = first; i < first + n; ++i )
+            {
+                rounds[d].emplace_back( m_min_mix_count, m_max_mix_count, d != 0, i == m_rnum - 1 );
+                rounds[d].back().SetContext( &m_prng, i );
+            }
+        }
 
-            tbox_t tbox_clear;
-            
-            if( !rounds[i].IsLast() )
+        auto create = [&]( size_t t )
+        {
+            CRound& r = rounds[t / n][t % n];
+            if( t < n )
             {
-                for( uint32_t cnt = 0; cnt < sizeof( tbox_t ); ++cnt  )
-					tbox_clear[cnt] = (*mds)[cnt][j];
+                r.CreateSboxes();
+                r.CreateMdsMatrix();
             }
             else
             {
-                for( uint32_t cnt = 0; cnt < sizeof( tbox_t ); ++cnt )
-                    tbox_clear[cnt] = ( cnt == j ) ? 1 : 0;
+                // Decryption round i undoes encryption round s. Every component has its own stream,
+                // so the s-boxes of round s and the MDS matrix of the round before it are created again.
+                uint32_t s = m_rnum - 1 - ( first + (uint32_t)( t % n ) );
+                uint32_t m = s ? s - 1 : 0;
+                CRound src( m_min_mix_count, m_max_mix_count, false, s == m_rnum - 1 );
+                CRound mds_src( m_min_mix_count, m_max_mix_count, false, m == m_rnum - 1 );
+                src.SetContext( &m_prng, s );
+                mds_src.SetContext( &m_prng, m );
+                src.CreateSboxes();
+                mds_src.CreateMdsMatrix();
+
+                CRound::s_boxes_t s_boxes_inv;
+                InverseSboxes( src.GetClearSboxes(), s_boxes_inv );
+                r.SetSboxes( s_boxes_inv );
+                r.SetSboxChaos( src.GetSboxChaos() );
+                r.SetMdsMatrix( r.IsLast() ? NGFMatrix::CCauchyMatrix() : mds_src.GetMdsMatrix(), mds_src.GetIrreduciblePoly() );
             }
+            if( !r.IsLast() )
+                r.CreateMixes();
+        };
 
-			NGFPoly::CPoly rnd_additive_mask(j < 15 ? NGFPoly::create_randomly(16, true, false) : (additive_masks_sum ^ rounds[i].GetAdditiveMask()));
-			additive_masks_sum = rnd_additive_mask ^ additive_masks_sum;
+        auto apply = [&]( size_t t )
+        {
+            size_t d = t / n, j = t % n;
+            CRound const* p = j ? &rounds[d][j - 1] : ( prev[d].empty() ? 0 : &prev[d][0] );
+            rounds[d][j].ApplyPrevMixes( p ? p->GetMixes() : no_mixes, p ? p->GetAdditiveMask() : no_mask );
+        };
 
-            for( uint32_t k = 0; k < 256; ++k )
+        auto format = [&]( size_t t )
+        {
+            size_t d = t / n, j = t % n;
+            uint32_t i = first + (uint32_t)j;
+            CRound const& r = rounds[d][j];
+            round_tbl_t& tbl = ( (round_tbl_t*)&tables[0] )[t];
+
+            key_round_t key;
+            RoundToKey( r, i, key );
+            uint8_t const* sboxes[16];
+            for( uint32_t k = 0; k < 16; ++k )
+                sboxes[k] = r.GetSboxes()[k].data();
+            expand_round( key, sboxes, tbl );
+            if( d )
             {
-                tbox_t tbox;
-                
-                for( uint32_t cnt = 0; cnt < sizeof( tbox_t ); ++cnt )
+                KeySboxes( r, j ? &rounds[d][j - 1] : ( prev[d].empty() ? 0 : &prev[d][0] ), key, clear ? &clear[j] : 0 );
+                keys[j] = key;
+            }
+
+            bool last = i == m_rnum - 1;
+            if( last )
+            {
+                sparse[d] = is_sparse_round( tbl );
+                if( sparse[d] )
+                    compress_round( tbl, final_sbox[d] );
+            }
+
+            text_t& text = texts[t];
+            text.clear();
+            if( !text_file[d].IsOpen() )
+                return;
+            if( !last || !sparse[d] )
+                text_of_round( text, tbl_name[d] + "_" + val_to_str( i ), tbl );
+            if( last )
+                text_epilogue( text, tbl_name[d], str_name[d], m_rnum, sparse[d] ? &final_sbox[d] : 0 );
+        };
+
+        // The files of both directions are written at the same time
+        auto write = [&]( size_t d )
+        {
+            for( uint32_t j = 0; j < n; ++j )
+            {
+                size_t t = d * n + j;
+                round_tbl_t const& tbl = ( (round_tbl_t const*)&tables[0] )[t];
+                text_file[d].Write( texts[t] );
+                if( first + j == m_rnum - 1 && sparse[d] )
+                    bin_file[d].Write( final_sbox[d], sizeof( round_sbox_t ) );
+                else
+                    bin_file[d].Write( tbl, sizeof( tbl ) );
+                if( d )
                 {
-                    tbox[cnt] = NGF2exp8::gmul_tab( rounds[i].GetSboxes()[j].at( k ), 
-                        tbox_clear[cnt], rounds[i].GetIrreduciblePoly() );
-                    for( std::vector<CRound::mix_t>::size_type mix_cnt = 0; mix_cnt < rounds[i].GetMixes().size(); ++mix_cnt )
+                    key_file.Write( &keys[j], sizeof( key_round_t ) );
+                    key_checksum = tbl_checksum( &keys[j], sizeof( key_round_t ), key_checksum );
+                    if( clear )
                     {
-                        tbox[cnt] =  NGF2exp8::gmul_tab( ( rounds[i].GetMixes()[mix_cnt] )[cnt].a, tbox[cnt],
-                            ( rounds[i].GetMixes()[mix_cnt] )[cnt].p );
+                        key_file.Write( clear[j], sizeof( round_sbox_t ) );
+                        key_checksum = tbl_checksum( clear[j], sizeof( round_sbox_t ), key_checksum );
                     }
-
-					if (!rounds[i].IsLast())
-					{
-						if (rounds[i].GetAdditiveMask().size() == 16)
-						{
-							tbox[cnt] ^= rnd_additive_mask[cnt];
-						}
-					}
                 }
-                
-                str_wb += tbox_to_str( tbox );
-                if( k != 255 )
-                    str_wb += ",\n";
-                else
-                    str_wb += "\n";
             }
+        };
 
-            if( j != 15 )
-                str_wb += "},\n";
-            else
-                str_wb += "}\n";  
+        run( 2 * n, create );
+        run( 2 * n, apply );
+        run( 2 * n, format );
+        run( 2, write );
+    }
+
+    // The headers cover all rounds, so they go last
+    for( int d = 0; d < 2; ++d )
+    {
+        text_file[d].Close();
+        if( !bin_file[d].IsOpen() )
+            continue;
+
+        init_tbl_head( head, d ? wb_decryption : wb_encryption, m_rnum, sparse[d] );
+        tbl_file_header_t* h = (tbl_file_header_t*)&head[0];
+        h->checksum = bin_file[d].Checksum( head.size(),
+            tbl_checksum( &head[sizeof( tbl_file_header_t )], head.size() - sizeof( tbl_file_header_t ) ) );
+        bin_file[d].WriteHead( &head[0], head.size() );
+        bin_file[d].Close();
+    }
+
+    key_file_header_t h;
+    init_key_header( h, m_rnum, m_key_flags, key_checksum );
+    key_file.WriteHead( &h, sizeof( h ) );
+    key_file.Close();
+}
+
+void CCipherCreator::CreateTables( CThreadPool* pool )
+{
+    m_encr_tables.resize( m_rnum * sizeof( round_tbl_t ) );
+    m_decr_tables.resize( m_rnum * sizeof( round_tbl_t ) );
+
+    // Rounds of both directions are independent
+    auto task = [this]( size_t i )
+    {
+        bool decr = i >= m_rnum;
+        uint32_t index = (uint32_t)( i % m_rnum );
+        round_tbl_t* tables = (round_tbl_t*)&( decr ? m_decr_tables : m_encr_tables )[0];
+        RoundToTables( ( decr ? m_anti_rounds : m_rounds )[index], index, tables[index] );
+    };
+
+    if( pool )
+        pool->Run( 2 * m_rnum, task );
+    else
+        for( size_t i = 0; i < 2 * m_rnum; ++i )
+            task( i );
+}
+
+double CCipherCreator::Verify( uint64_t count, CThreadPool* pool ) const
+{
+    if( m_encr_tables.empty() || m_decr_tables.empty() )
+        throw std::runtime_error( "ERROR: Tables are not created!!!\n" );
+
+    // The table sets refer to the tables of the creator, only a sparse last round is copied
+    std::vector<round_ptr_t> encr_rounds( m_rnum ), decr_rounds( m_rnum );
+    for( uint32_t i = 0; i < m_rnum; ++i )
+    {
+        encr_rounds[i] = ( (round_tbl_t const*)&m_encr_tables[0] )[i];
+        decr_rounds[i] = ( (round_tbl_t const*)&m_decr_tables[0] )[i];
+    }
+    CTableSet encr, decr;
+    encr.Attach( wb_encryption, &encr_rounds[0], m_rnum );
+    decr.Attach( wb_decryption, &decr_rounds[0], m_rnum );
+
+    // A chunk of 64 KB is random, encrypted and decrypted by one thread.
+    // After a mismatch the other threads skip their chunks.
+    size_t const chunk = 4096;
+    size_t const chunks = (size_t)( ( count + chunk - 1 ) / chunk );
+    std::atomic<bool> failed( false );
+
+    auto task = [&]( size_t c )
+    {
+        if( failed )
+            return;
+
+        uint64_t first = c * (uint64_t)chunk;
+        size_t n = (size_t)( ( count - first < chunk ) ? count - first : chunk );
+        std::vector<uint8_t> in( n * block_size ), out( n * block_size );
+        NPrng::fill( &in[0], in.size() );
+        encrypt_blocks( encr, &in[0], &out[0], n );
+        decrypt_blocks( decr, &out[0], &out[0], n );
+
+        for( size_t i = 0; i < n; ++i )
+        {
+            if( memcmp( &in[i * block_size], &out[i * block_size], block_size ) )
+            {
+                failed = true;
+                throw std::runtime_error( "ERROR: Block " + std::to_string( first + i ) + " is not decrypted to itself!!!\n" );
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    if( pool )
+        pool->Run( chunks, task );
+    else
+        for( size_t i = 0; i < chunks; ++i )
+            task( i );
+    std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+    return time.count() > 0 ? count / time.count() : 0;
+}
+
+void CCipherCreator::Flash( std::string const& fname_encr, std::string const& fname_decr, CThreadPool* pool )
+{
+    if( m_encr_tables.empty() )
+        CreateTables( pool );
+
+    // Parts of both files are formatted together, then the files are written at the same time
+    text_file_t files[2];
+    init_text_file( files[0], fname_encr, "wb_encr_tbl", m_encr_tables, m_rnum );
+    init_text_file( files[1], fname_decr, "wb_decr_tbl", m_decr_tables, m_rnum );
+
+    size_t count = files[0].parts.size() + files[1].parts.size();
+    auto format = [&files]( size_t i )
+    {
+        size_t n = files[0].parts.size();
+        if( i < n )
+            text_part( files[0], i );
+        else
+            text_part( files[1], i - n );
+    };
+    auto write = [&files]( size_t i )
+    {
+        write_text_file( files[i] );
+        std::vector<text_t>().swap( files[i].parts );
+    };
+
+    if( pool )
+    {
+        pool->Run( count, format );
+        pool->Run( 2, write );
+    }
+    else
+    {
+        for( size_t i = 0; i < count; ++i )
+            format( i );
+        write( 0 );
+        write( 1 );
+    }
+}
+
+void CCipherCreator::FlashBinary( std::string const& fname_encr, std::string const& fname_decr )
+{
+    if( m_encr_tables.empty() )
+        CreateTables();
+
+    FlashBinaryFile( fname_encr, wb_encryption, m_encr_tables );
+    FlashBinaryFile( fname_decr, wb_decryption, m_decr_tables );
+}
+
+void CCipherCreator::RoundToKey( CRound const& round, uint32_t i, key_round_t& key )
+{
+    // The T-boxes of the round from its s-boxes. The s-boxes themselves are in KeySboxes.
+    memset( &key, 0, sizeof( key ) );
+
+    key.poly = round.GetIrreduciblePoly();
+    key.last = round.IsLast() ? 1 : 0;
+
+    // The last round has the identity instead of the MDS matrix
+	NGFMatrix::CMatrix inv_mds;
+	if (round.IsDecyption() && !round.IsLast())
+		round.GetMdsMatrix().Inverse(inv_mds);
+	const NGFMatrix::CMatrix& mds = round.IsDecyption() ? inv_mds : round.GetMdsMatrix().GetNativeMatrix();
+
+    for( uint32_t cnt = 0; cnt < 16; ++cnt )
+    {
+        for( uint32_t j = 0; j < 16; ++j )
+            key.mds[cnt][j] = round.IsLast() ? ( ( cnt == j ) ? 1 : 0 ) : mds[cnt][j];
+    }
+
+    // The mixes of a byte of a T-box entry compose into one linear map
+    for( uint32_t cnt = 0; cnt < sizeof( tbox_t ); ++cnt )
+    {
+        NGF2exp8::CAffineMap mixes;
+        for( std::vector<CRound::mix_t>::size_type mix_cnt = 0; mix_cnt < round.GetMixes().size(); ++mix_cnt )
+            mixes.Mul( ( round.GetMixes()[mix_cnt] )[cnt].a, ( round.GetMixes()[mix_cnt] )[cnt].p );
+        memcpy( key.mixes[cnt], mixes.Cols(), 8 );
+    }
+
+    // Every T-box takes a random mask, and the masks of a round add up to the mask of the round
+    NPrng::CStreamScope scope( &m_prng, i, round.IsDecyption(), NPrng::rnd_tables );
+
+	NGFPoly::CPoly additive_masks_sum;
+	additive_masks_sum.reserve(16);
+	additive_masks_sum.volatile_size(false);
+
+    for( uint32_t j = 0; j < 16; ++j )
+    {   
+		NGFPoly::CPoly rnd_additive_mask(j < 15 ? NGFPoly::create_randomly(16, true, false) : (additive_masks_sum ^ round.GetAdditiveMask()));
+		additive_masks_sum = rnd_additive_mask ^ additive_masks_sum;
+
+        if( !round.IsLast() && round.GetAdditiveMask().size() == 16 )
+        {
+            for( uint32_t cnt = 0; cnt < sizeof( tbox_t ); ++cnt )
+                key.masks[j][cnt] = rnd_additive_mask[cnt];
         }
-        
-        str_wb += "};\n";       
     }
+}
 
-    str_wb += "\n#endif // " + str_name + "_H\n";
-    fwrite( str_wb.c_str(), sizeof( char ), str_wb.size(), f );
+void CCipherCreator::KeySboxes( CRound const& round, CRound const* prev, key_round_t& key, round_sbox_t* clear )
+{
+    // A decryption round keeps the start points of the encryption round whose s-boxes it inverts
+    NPrng::fixed_t const* chaos = round.GetSboxChaos();
+    for( uint32_t j = 0; j < 16; ++j )
+        memcpy( key.chaos[j], chaos[j].w, sizeof( key.chaos[j] ) );
 
+    // The clear s-boxes of the start points, a decryption round has their inverses (see InverseSboxes)
+    if( clear )
+    {
+        CRound::s_boxes_t const& s = round.GetClearSboxes();
+        for( uint32_t j = 0; j < 16; ++j )
+        {
+            if( !round.IsDecyption() )
+            {
+                memcpy( ( *clear )[j], s[j].data(), sizeof( ( *clear )[j] ) );
+                continue;
+            }
+            CRound::sbox_t const& inv = s[( j + ( j % 4 ) * 4 ) % 16];
+            for( uint32_t x = 0; x < 256; ++x )
+                ( *clear )[j][inv[x]] = (uint8_t)x;
+        }
+    }
+
+    NGF2exp8::CAffineMap input[16];
+    if( prev )
+        round.InputMaps( prev->GetMixes(), prev->GetAdditiveMask(), input );
+    for( uint32_t j = 0; j < 16; ++j )
+    {
+        memcpy( key.input[j], input[j].Cols(), 8 );
+        key.input[j][8] = input[j].Const();
+    }
+}
+
+void CCipherCreator::RoundToTables( CRound const& round, uint32_t i, round_tbl_t& tbl )
+{
+    // Convert the round to T-boxes
+    key_round_t key;
+    RoundToKey( round, i, key );
+
+    uint8_t const* sboxes[16];
+    for( uint32_t j = 0; j < 16; ++j )
+        sboxes[j] = round.GetSboxes()[j].data();
+    expand_round( key, sboxes, tbl );
+}
+
+void CCipherCreator::FlashKey( std::string const& fname )
+{
+    // The decryption rounds (see keyformat.h)
+    uint32_t const round_size = key_round_size( m_key_flags );
+    std::vector<uint8_t> buf( sizeof( key_file_header_t ) + m_rnum * (size_t)round_size, 0 );
+    uint8_t* rounds = &buf[sizeof( key_file_header_t )];
+    for( uint32_t i = 0; i < m_rnum; ++i )
+    {
+        key_round_t& key = *(key_round_t*)( rounds + i * (size_t)round_size );
+        RoundToKey( m_anti_rounds[i], i, key );
+        KeySboxes( m_anti_rounds[i], i ? &m_anti_rounds[i - 1] : 0, key,
+            ( m_key_flags & key_flag_sboxes ) ? (round_sbox_t*)( &key + 1 ) : 0 );
+    }
+
+    init_key_header( *(key_file_header_t*)&buf[0], m_rnum, m_key_flags, tbl_checksum( rounds, m_rnum * (size_t)round_size ) );
+
+    FILE* f;
+    errno_t err = fopen_s( &f, fname.c_str(), "wb" );  
+    if( err != 0 )
+        throw std::runtime_error( std::string( "ERROR: Can\'t open \'" ) + fname + "\' file!!!\n" );
+
+    bool ok = fwrite( &buf[0], 1, buf.size(), f ) == buf.size();
     fclose( f );
+
+    if( !ok )
+        throw std::runtime_error( std::string( "ERROR: Can\'t write \'" ) + fname + "\' file!!!\n" );
+}
+
+void CCipherCreator::FlashOneFile( std::string const& fname, std::string const& tbl_name, tables_t const& tables )
+{
+    text_file_t f;
+    init_text_file( f, fname, tbl_name, tables, m_rnum );
+    for( size_t i = 0; i < f.parts.size(); ++i )
+        text_part( f, i );
+    write_text_file( f );
+}
+
+void CCipherCreator::FlashBinaryFile( std::string const& fname, direction_t dir, tables_t const& tables )
+{
+    // A sparse last round goes after the others as 16 byte substitutions
+    round_sbox_t sbox;
+    round_tbl_t const& last = ( (round_tbl_t const*)&tables[0] )[m_rnum - 1];
+    bool sparse = is_sparse_round( last );
+    size_t tbox_size = ( sparse ? m_rnum - 1 : m_rnum ) * sizeof( round_tbl_t );
+    if( sparse )
+        compress_round( last, sbox );
+
+    std::vector<uint8_t> head;
+    init_tbl_head( head, dir, m_rnum, sparse );
+
+    tbl_file_header_t* h = (tbl_file_header_t*)&head[0];
+    h->checksum = tbl_checksum( &tables[0], tbox_size,
+        tbl_checksum( &head[sizeof( tbl_file_header_t )], head.size() - sizeof( tbl_file_header_t ) ) );
+    if( sparse )
+        h->checksum = tbl_checksum( sbox, sizeof( sbox ), h->checksum );
+
+    FILE* f;
+    errno_t err = fopen_s( &f, fname.c_str(), "wb" );  
+    if( err != 0 )
+        throw std::runtime_error( std::string( "ERROR: Can\'t open \'" ) + fname + "\' file!!!\n" );
+
+    bool ok = fwrite( &head[0], 1, head.size(), f ) == head.size() &&
+        fwrite( &tables[0], 1, tbox_size, f ) == tbox_size &&
+        ( !sparse || fwrite( sbox, 1, sizeof( sbox ), f ) == sizeof( sbox ) );
+    fclose( f );
+
+    if( !ok )
+        throw std::runtime_error( std::string( "ERROR: Can\'t write \'" ) + fname + "\' file!!!\n" );
 }
 
 }
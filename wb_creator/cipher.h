@@ -26,7 +26,11 @@
 #define CIPHER_H
 
 #include "round.h"
+#include "tblformat.h"
+#include "keyformat.h"
+#include "pool.h"
 #include <string>
+#include <functional>
 
 namespace NWhiteBox
 {
@@ -38,9 +42,57 @@ public:
     virtual ~CCipherCreator();
 
 public:
-    void Flash( std::string const& fname_encr, std::string const& fname_decr );
-    void FlashOneFile( std::string const& fname, std::string const& tbl_name, std::vector<CRound> const& rounds );
-    void Init();
+    typedef std::vector<uint8_t>    tables_t;   // rounds number * sizeof( round_tbl_t ) bytes
+
+public:
+    void Flash( std::string const& fname_encr, std::string const& fname_decr, CThreadPool* pool = 0 );
+    void FlashBinary( std::string const& fname_encr, std::string const& fname_decr );
+    void FlashOneFile( std::string const& fname, std::string const& tbl_name, tables_t const& tables );
+    void FlashBinaryFile( std::string const& fname, direction_t dir, tables_t const& tables );
+    // The compact decryption key (see keyformat.h). CTableSet::Expand of wb_runtime builds the tables of it.
+    void FlashKey( std::string const& fname );
+    // key_flag_* of the compact key, key_flag_sboxes by default. Devices take the flags of the master.
+    void SetKeyFlags( uint32_t flags );
+    // Rounds and tables are built by the threads of the pool (by the calling thread if it is 0)
+    void Init( CThreadPool* pool = 0 );
+    void CreateTables( CThreadPool* pool = 0 );
+
+    // Seeded mode: the same master seed gives the same tables (see NPrng::CStream).
+    // Otherwise every Init takes a new master seed from the OS.
+    void SetSeed( uint8_t const seed[32] );
+
+    // Device diversification instead of Init: the clear s-boxes and MDS matrices of the rounds
+    // of an initialized master, and new mixes and masks of the seed of this creator. The tables
+    // differ from the ones of the master, but they encrypt and decrypt the same way.
+    void Reencode( CCipherCreator const& master, CThreadPool* pool = 0 );
+
+    // Re-encodes the key for devices [first, first + count), device k takes the seed derived
+    // from the master seed for k. device( k, creator ) gets the creator with the tables of device k.
+    // Devices are created by the threads of the pool at the same time, one device per thread.
+    typedef std::function<void ( uint32_t, CCipherCreator& )> device_t;
+    void CreateDevices( uint32_t first, uint32_t count, device_t const& device, CThreadPool* pool = 0 );
+
+    // Output files of Stream, a file with an empty name is not written
+    struct stream_files_t
+    {
+        std::string     encr_header;    // wb_encr_tbl.h
+        std::string     decr_header;
+        std::string     encr_binary;    // wb_encr_tbl.bin
+        std::string     decr_binary;
+        std::string     decr_key;       // wb_decr_key.bin
+    };
+
+    // Instead of Init, CreateTables and the Flash functions for keys of many rounds: a window of rounds
+    // of both directions (a round per thread of the pool) is built, written and dropped, and only
+    // the mixes and the mask of its last round stay for the next window. A decryption round creates
+    // the s-boxes of its encryption round again from their stream, so the memory doesn't depend
+    // on the number of rounds. The files are the same as of the Flash functions for the same seed.
+    void Stream( stream_files_t const& files, CThreadPool* pool = 0 );
+
+    // Checks decryption of encryption on count random blocks with the tables in memory (after
+    // CreateTables) and the fastest kernel of the CPU, chunks of blocks go to the threads of the pool.
+    // Throws on the first block which doesn't come back. Returns the number of blocks per second.
+    double Verify( uint64_t count, CThreadPool* pool = 0 ) const;
 
 public:
     uint32_t GetRoundsNum() const
@@ -68,12 +120,34 @@ public:
         return m_max_mix_count;
     }
 
+    tables_t const& GetEncrTables() const
+    {
+        return m_encr_tables;
+    }
+
+    tables_t const& GetDecrTables() const
+    {
+        return m_decr_tables;
+    }
+
+private:
+    // Round i of either direction, prev is the round before it (0 for the first one)
+    void RoundToKey( CRound const& round, uint32_t i, key_round_t& key );
+    // clear gets the clear s-boxes of the start points of key if it isn't 0
+    void KeySboxes( CRound const& round, CRound const* prev, key_round_t& key, round_sbox_t* clear );
+    void RoundToTables( CRound const& round, uint32_t i, round_tbl_t& tbl );
+
 private:
     uint32_t                m_rnum;
     uint32_t                m_min_mix_count;
     uint32_t                m_max_mix_count;
     std::vector<CRound>     m_rounds;
     std::vector<CRound>     m_anti_rounds;
+    tables_t                m_encr_tables;
+    tables_t                m_decr_tables;
+    NPrng::CContext         m_prng;
+    bool                    m_seeded;
+    uint32_t                m_key_flags;
     
 };
 
@@ -0,0 +1,200 @@
+//***************************************************************************************
+// gf2exp8.cpp
+// GF(2^8) multiplication lookup tables
+//
+// Copyright  2009-2010, 2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_creator.
+//
+// wb_creator is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_creator.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+#include "gf2exp8.h"
+#include <stdexcept>
+
+namespace NGF2exp8
+{
+
+const uint8_t rijndael_field_poly = 0x1b;
+const uint8_t rijndael_primitive_element = 0x03;
+
+namespace
+{
+
+const uint32_t fields_count = 30;
+
+// All irreducible polynomials x^8 + p(x), a byte keeps p(x)
+constexpr uint8_t polys[fields_count] =
+{
+	0x1b, 0x1d, 0x2b, 0x2d, 0x39, 0x3f, 0x4d, 0x5f, 0x63, 0x65,
+	0x69, 0x71, 0x77, 0x7b, 0x87, 0x8b, 0x8d, 0x9f, 0xa3, 0xa9,
+	0xb1, 0xbd, 0xc3, 0xcf, 0xd7, 0xdd, 0xe7, 0xf3, 0xf5, 0xf9
+};
+
+// exp[log[a] + log[b]] is a * b. log[0] points to the zero half of exp,
+// so zero operands need no checks
+struct field_tables_t
+{
+	uint8_t		exp[1024];		// g^(i mod 255) for i < 510, zeros above
+	uint16_t	log[256];
+	uint8_t		inv[256];		// inv[0] = 0
+};
+
+struct fields_t
+{
+	field_tables_t	f[fields_count];
+	uint8_t			index[256];		// poly -> f, fields_count for reducible ones
+};
+
+constexpr uint8_t slow_mul(uint8_t a, uint8_t b, uint8_t p)
+{
+	uint8_t r = 0;
+	for (; b; b >>= 1)
+	{
+		if (b & 1)
+			r ^= a;
+		a = (uint8_t)((a << 1) ^ ((a & 0x80) ? p : 0));
+	}
+	return r;
+}
+
+constexpr uint8_t slow_pow(uint8_t a, uint32_t n, uint8_t p)
+{
+	uint8_t r = 1;
+	for (; n; n >>= 1)
+	{
+		if (n & 1)
+			r = slow_mul(r, a, p);
+		a = slow_mul(a, a, p);
+	}
+	return r;
+}
+
+// The multiplicative group has order 255 = 3 * 5 * 17
+constexpr bool is_generator(uint8_t g, uint8_t p)
+{
+	return slow_pow(g, 255 / 3, p) != 1 && slow_pow(g, 255 / 5, p) != 1 && slow_pow(g, 255 / 17, p) != 1;
+}
+
+constexpr field_tables_t make_field(uint8_t p, uint8_t g)
+{
+	field_tables_t t = {};
+
+	uint8_t x = 1;
+	for (uint32_t i = 0; i < 255; ++i)
+	{
+		t.exp[i] = t.exp[i + 255] = x;
+		t.log[x] = (uint16_t)i;
+		x = slow_mul(x, g, p);
+	}
+	t.log[0] = 510;
+
+	for (uint32_t i = 1; i < 256; ++i)
+		t.inv[i] = t.exp[255 - t.log[i]];
+	return t;
+}
+
+constexpr fields_t make_fields()
+{
+	fields_t t = {};
+
+	for (uint32_t i = 0; i < 256; ++i)
+		t.index[i] = (uint8_t)fields_count;
+
+	for (uint32_t i = 0; i < fields_count; ++i)
+	{
+		uint8_t g = 2;
+		while (!is_generator(g, polys[i]))
+			++g;
+		t.f[i] = make_field(polys[i], g);
+		t.index[polys[i]] = (uint8_t)i;
+	}
+	return t;
+}
+
+constexpr fields_t fields = make_fields();
+
+// Powers of rijndael_primitive_element, which is not necessarily the generator of fields
+constexpr field_tables_t rijndael = make_field(rijndael_field_poly, rijndael_primitive_element);
+
+static_assert(fields.index[rijndael_field_poly] == 0, "Rijndael field must be the first one");
+static_assert(is_generator(rijndael_primitive_element, rijndael_field_poly), "Illegal primitive element");
+
+inline field_tables_t const& field(uint8_t p)
+{
+	uint8_t i = fields.index[p];
+	if (i == fields_count)
+		throw std::runtime_error("ERROR: Illegal irreducible polynomial!!!\n");
+	return fields.f[i];
+}
+
+}
+
+uint8_t get_poly_by_index(int i)
+{
+	if (i < 0 || (uint32_t)i >= fields_count)
+		throw std::runtime_error("ERROR: Illegal index of irreducible polynomial!!!\n");
+	return polys[i];
+}
+
+uint8_t gmul_tab(uint8_t a, uint8_t b, uint8_t p)
+{
+	field_tables_t const& f = field(p);
+	return f.exp[f.log[a] + f.log[b]];
+}
+
+uint8_t inv_tab(uint8_t b, uint8_t p)
+{
+	return field(p).inv[b];
+}
+
+uint8_t gdiv_tab(uint8_t a, uint8_t b, uint8_t p)
+{
+	if (!b)
+		throw std::runtime_error("ERROR: Division by zero!!!\n");
+
+	field_tables_t const& f = field(p);
+	return f.exp[f.log[a] + f.log[f.inv[b]]];
+}
+
+void gmul_span(uint8_t const* a, uint8_t b, uint8_t* res, size_t count, uint8_t p)
+{
+	field_tables_t const& f = field(p);
+	uint8_t const* e = f.exp + f.log[b];
+	for (size_t i = 0; i < count; ++i)
+		res[i] = e[f.log[a[i]]];
+}
+
+void gmul_spans(uint8_t const* a, uint8_t const* b, uint8_t* res, size_t count, uint8_t p)
+{
+	field_tables_t const& f = field(p);
+	for (size_t i = 0; i < count; ++i)
+		res[i] = f.exp[f.log[a[i]] + f.log[b[i]]];
+}
+
+uint8_t* rijndael_create_exp_table(uint8_t tbl[256])
+{
+	for (uint32_t i = 0; i < 256; ++i)
+		tbl[i] = rijndael.exp[i];
+	return tbl;
+}
+
+uint8_t rijndael_get_primitive_element_power(int power)
+{
+	power %= 255;
+	return rijndael.exp[(power < 0) ? (power + 255) : power];
+}
+
+}
@@ -25,6 +25,7 @@
 #define GF2EXP8_H
 
 #include "stdtypes.h"
+#include <stddef.h>
 
 namespace NGF2exp8
 {
@@ -36,6 +37,10 @@ uint8_t gmul_tab( uint8_t a, uint8_t b, uint8_t p );
 uint8_t inv_tab( uint8_t b, uint8_t p );
 uint8_t gdiv_tab( uint8_t a, uint8_t b, uint8_t p );
 
+// res[i] = a[i] * b and res[i] = a[i] * b[i]; res may be a
+void gmul_span(uint8_t const* a, uint8_t b, uint8_t* res, size_t count, uint8_t p);
+void gmul_spans(uint8_t const* a, uint8_t const* b, uint8_t* res, size_t count, uint8_t p);
+
 // Rijndael field specific
 uint8_t* rijndael_create_exp_table(uint8_t tbl[256]);
 uint8_t	 rijndael_get_primitive_element_power(int power);
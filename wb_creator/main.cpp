@@ -25,6 +25,9 @@
 #include "poly.h"
 #include "prng.h"
 #include "cipher.h"
+#include "engine.h"
+#include <vector>
+#include <string>
 
 
 static char* const hello = { 
@@ -44,32 +47,175 @@ static char* const hello = {
 
 	"You should have received a copy of the GNU General Public License\n"
 	"along with this program.If not, see <http://www.gnu.org/licenses/>.\n\n\n"
-    "USAGE: wb_creator.exe number_of_rounds min_number_of_mixes max_number_of_mixes\n\n"
+    "USAGE: wb_creator.exe [--count N | --devices D | --stream] [--jobs J] [--verify V] [--small-key] number_of_rounds min_number_of_mixes max_number_of_mixes [seed]\n\n"
+    "seed is a master seed of 64 hex digits. The same seed gives the same tables.\n"
+    "--count N creates N independent keys (wb_encr_tbl_0.h, wb_decr_tbl_0.h, ...), J of them at a time.\n"
+    "With a seed every key of the batch has its own seed derived from it.\n"
+    "--devices D creates a key and D re-encodings of it (wb_encr_tbl_dev0.h, ...) with new mixes and masks,\n"
+    "which encrypt and decrypt like the key.\n"
+    "--stream writes every round as soon as it is built, so the memory doesn't depend on number_of_rounds.\n"
+    "--verify V encrypts and decrypts V random blocks (1048576 by default, 0 to skip) with the tables of every key\n"
+    "before they are written and stops on the first block which doesn't come back (not with --stream).\n"
+    "--small-key writes wb_decr_key.bin without the clear s-boxes: 1.3 KB instead of 5.3 KB per round,\n"
+    "but CTableSet::Expand runs the chaotic map for every s-box and takes about 10 times longer.\n"
+    "J is one per CPU core by default.\n\n"
 };
 
+// 64 hex digits to 32 bytes
+static bool parse_seed( char const* s, uint8_t seed[32] )
+{
+    if( strlen( s ) != 64 )
+        return false;
+
+    for( int i = 0; i < 64; ++i )
+    {
+        char c = s[i];
+        uint8_t d;
+        if( c >= '0' && c <= '9' )
+            d = (uint8_t)( c - '0' );
+        else if( c >= 'a' && c <= 'f' )
+            d = (uint8_t)( c - 'a' + 10 );
+        else if( c >= 'A' && c <= 'F' )
+            d = (uint8_t)( c - 'A' + 10 );
+        else
+            return false;
+
+        seed[i / 2] = ( i % 2 ) ? (uint8_t)( seed[i / 2] | d ) : (uint8_t)( d << 4 );
+    }
+    return true;
+}
+
+// Writes the tables of the creator to the files with the suffix
+static void flash_key( NWhiteBox::CCipherCreator& c, std::string const& suffix, NWhiteBox::CThreadPool* pool )
+{
+    c.Flash( "wb_encr_tbl" + suffix + ".h", "wb_decr_tbl" + suffix + ".h", pool );
+    c.FlashBinary( "wb_encr_tbl" + suffix + ".bin", "wb_decr_tbl" + suffix + ".bin" );
+    c.FlashKey( "wb_decr_key" + suffix + ".bin" );
+}
+
+// Round trip of blocks random blocks with the tables of the creator, throws on a mismatch
+static void verify_key( NWhiteBox::CCipherCreator const& c, uint64_t blocks, NWhiteBox::CThreadPool* pool, bool report )
+{
+    if( !blocks )
+        return;
+
+    double speed = c.Verify( blocks, pool );
+    if( report )
+        printf_s( "%llu blocks verified, %.0f blocks/s (%s kernel)\n", (unsigned long long)blocks, speed,
+            NWhiteBox::kernel_name( NWhiteBox::best_kernel() ) );
+}
+
+// Creates a key, verifies and writes it to the files with the suffix. A null seed means a random key.
+static void create_key( NWhiteBox::CCipherCreator& c, uint8_t const* seed, std::string const& suffix, uint64_t verify,
+    uint32_t key_flags, NWhiteBox::CThreadPool* pool )
+{
+    if( seed )
+        c.SetSeed( seed );
+    c.SetKeyFlags( key_flags );
+    c.Init( pool );
+    c.CreateTables( pool );
+    verify_key( c, verify, pool, pool != 0 );
+    flash_key( c, suffix, pool );
+}
+
 int main( int argc, char* argv[] )
 {
     
     printf_s( "%s", hello );
+
+    uint32_t count = 1;
+    uint32_t devices = 0;
+    uint32_t jobs = 0;
+    bool stream = false;
+    uint64_t verify = 1 << 20;
+    uint32_t key_flags = NWhiteBox::key_flag_sboxes;
+    std::vector<char const*> args;
+    for( int i = 1; i < argc; ++i )
+    {
+        std::string a( argv[i] );
+        if( a == "--count" && i + 1 < argc )
+            count = (uint32_t)atol( argv[++i] );
+        else if( a == "--devices" && i + 1 < argc )
+            devices = (uint32_t)atol( argv[++i] );
+        else if( a == "--jobs" && i + 1 < argc )
+            jobs = (uint32_t)atol( argv[++i] );
+        else if( a == "--stream" )
+            stream = true;
+        else if( a == "--verify" && i + 1 < argc )
+            verify = strtoull( argv[++i], 0, 10 );
+        else if( a == "--small-key" )
+            key_flags = 0;
+        else
+            args.push_back( argv[i] );
+    }
     
-    if( argc != 4 )
+    if( ( args.size() != 3 && args.size() != 4 ) || !count || ( count > 1 && devices ) || ( stream && ( count > 1 || devices ) ) )
     {
-        printf_s( "%s", "Use wb_creator.exe number_of_rounds min_number_of_mixes max_number_of_mixes!\n" );
+        printf_s( "%s", "Use wb_creator.exe [--count N | --devices D | --stream] [--jobs J] [--verify V] [--small-key] number_of_rounds min_number_of_mixes max_number_of_mixes [seed]!\n" );
         return 1;
     }
 
-    uint32_t rounds_num = (uint32_t)atol( argv[1] );
-    uint32_t min_mixes_num = (uint32_t)atol( argv[2] );
-    uint32_t max_mixes_num = (uint32_t)atol( argv[3] );
+    uint32_t rounds_num = (uint32_t)atol( args[0] );
+    uint32_t min_mixes_num = (uint32_t)atol( args[1] );
+    uint32_t max_mixes_num = (uint32_t)atol( args[2] );
 
     try
     {
         if( min_mixes_num > max_mixes_num )
             throw std::runtime_error( "ERROR: min_mixes_number must be less or equal to max_mixes_number!!!\n" );
-        
-        NWhiteBox::CCipherCreator c( rounds_num, min_mixes_num, max_mixes_num );
-        c.Init();
-        c.Flash( "wb_encr_tbl.h", "wb_decr_tbl.h" );
+
+        uint8_t seed[32] = { 0 };
+        bool seeded = args.size() == 4;
+        if( seeded && !parse_seed( args[3], seed ) )
+            throw std::runtime_error( "ERROR: seed must be 64 hex digits!!!\n" );
+
+        NWhiteBox::CThreadPool pool( jobs );
+        if( stream )
+        {
+            NWhiteBox::CCipherCreator c( rounds_num, min_mixes_num, max_mixes_num );
+            if( seeded )
+                c.SetSeed( seed );
+            c.SetKeyFlags( key_flags );
+
+            NWhiteBox::CCipherCreator::stream_files_t files;
+            files.encr_header = "wb_encr_tbl.h";
+            files.decr_header = "wb_decr_tbl.h";
+            files.encr_binary = "wb_encr_tbl.bin";
+            files.decr_binary = "wb_decr_tbl.bin";
+            files.decr_key = "wb_decr_key.bin";
+            c.Stream( files, &pool );
+        }
+        else if( count == 1 )
+        {
+            NWhiteBox::CCipherCreator c( rounds_num, min_mixes_num, max_mixes_num );
+            create_key( c, seeded ? seed : 0, "", verify, key_flags, &pool );
+
+            if( devices )
+            {
+                c.CreateDevices( 0, devices, [&]( uint32_t k, NWhiteBox::CCipherCreator& d )
+                {
+                    // This runs on a thread of the pool, which creates devices in parallel already:
+                    // a Run of the pool from here would do the blocks on this thread anyway (see pool.h)
+                    verify_key( d, verify, 0, false );
+                    flash_key( d, "_dev" + std::to_string( k ), 0 );
+                }, &pool );
+                printf_s( "%u devices created\n", devices );
+            }
+        }
+        else
+        {
+            // Keys of a batch share nothing, so every thread creates whole keys one after another
+            NPrng::CContext master( seed );
+            pool.Run( count, [&]( size_t k )
+            {
+                uint8_t key_seed[32];
+                if( seeded )
+                    master.DeriveSeed( (uint32_t)k, key_seed );
+                NWhiteBox::CCipherCreator c( rounds_num, min_mixes_num, max_mixes_num );
+                create_key( c, seeded ? key_seed : 0, "_" + std::to_string( k ), verify, key_flags, 0 );
+            } );
+            printf_s( "%u keys created\n", count );
+        }
     }
     catch( std::runtime_error& e )
     {
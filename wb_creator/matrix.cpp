@@ -27,30 +27,275 @@
 #include "matrix.h"
 #include "prng.h"
 #include "sbox.h"
+#include "affine.h"
+#include "kernels.h"
+#include <algorithm>
+
+#ifdef WB_SSSE3
+#include <tmmintrin.h>
+#endif // WB_SSSE3
+#ifdef WB_GFNI
+#include <immintrin.h>
+#endif // WB_GFNI
 
 namespace NGFMatrix
 {
 
+//
+// Row kernels
+//
+
+// Multiplication by a constant c in a field
+struct mul_const_t
+{
+	uint8_t		lo[16];		// c * i
+	uint8_t		hi[16];		// c * (i << 4)
+	uint64_t	gfni;		// the bit matrix of x * c for GF2P8AFFINEQB
+};
+
+static void prepare_const(mul_const_t& k, uint8_t c, uint8_t field)
+{
+	// cols[i] = c * x^i
+	uint8_t cols[8];
+	cols[0] = c;
+	for (uint32_t i = 1; i < 8; ++i)
+		cols[i] = (uint8_t)((cols[i - 1] << 1) ^ ((cols[i - 1] & 0x80) ? field : 0));
+
+	k.lo[0] = k.hi[0] = 0;
+	for (uint32_t n = 1; n < 16; ++n)
+	{
+		uint32_t i(0);
+		while (!(n & (1 << i)))
+			++i;
+		k.lo[n] = k.lo[n & (n - 1)] ^ cols[i];
+		k.hi[n] = k.hi[n & (n - 1)] ^ cols[i + 4];
+	}
+	k.gfni = NGF2exp8::gfni_matrix(cols);
+}
+
+// dst = (add ? dst : 0) ^ c * src
+typedef void (*row_kernel_t)(uint8_t* dst, const uint8_t* src, mul_const_t const& k, uint32_t len, bool add);
+
+static void row_scalar(uint8_t* dst, const uint8_t* src, mul_const_t const& k, uint32_t len, bool add)
+{
+	for (uint32_t i = 0; i < len; ++i)
+	{
+		uint8_t p = k.lo[src[i] & 0x0f] ^ k.hi[src[i] >> 4];
+		dst[i] = add ? (dst[i] ^ p) : p;
+	}
+}
+
+#ifdef WB_SSSE3
+
+WB_TARGET_SSSE3 static void row_ssse3(uint8_t* dst, const uint8_t* src, mul_const_t const& k, uint32_t len, bool add)
+{
+	__m128i lo = _mm_loadu_si128((__m128i const*)k.lo);
+	__m128i hi = _mm_loadu_si128((__m128i const*)k.hi);
+	__m128i mask = _mm_set1_epi8(0x0f);
+
+	uint32_t i(0);
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((__m128i const*)(src + i));
+		__m128i p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(x, mask)),
+			_mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(x, 4), mask)));
+		if (add)
+			p = _mm_xor_si128(p, _mm_loadu_si128((__m128i const*)(dst + i)));
+		_mm_storeu_si128((__m128i*)(dst + i), p);
+	}
+	row_scalar(dst + i, src + i, k, len - i, add);
+}
+
+#endif // WB_SSSE3
+
+#ifdef WB_GFNI
+
+WB_TARGET_GFNI static void row_gfni(uint8_t* dst, const uint8_t* src, mul_const_t const& k, uint32_t len, bool add)
+{
+	__m128i m = _mm_set1_epi64x((long long)k.gfni);
+
+	uint32_t i(0);
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i p = _mm_gf2p8affine_epi64_epi8(_mm_loadu_si128((__m128i const*)(src + i)), m, 0);
+		if (add)
+			p = _mm_xor_si128(p, _mm_loadu_si128((__m128i const*)(dst + i)));
+		_mm_storeu_si128((__m128i*)(dst + i), p);
+	}
+	row_scalar(dst + i, src + i, k, len - i, add);
+}
+
+#endif // WB_GFNI
+
+static row_kernel_t select_row_kernel()
+{
+	uint32_t features = NWhiteBox::cpu_features();
+	(void)features;
+#ifdef WB_GFNI
+	if (features & NWhiteBox::wb_cpu_gfni)
+		return row_gfni;
+#endif // WB_GFNI
+#ifdef WB_SSSE3
+	if (features & NWhiteBox::wb_cpu_ssse3)
+		return row_ssse3;
+#endif // WB_SSSE3
+	return row_scalar;
+}
+
+static row_kernel_t row_kernel()
+{
+	static row_kernel_t const kernel = select_row_kernel();
+	return kernel;
+}
+
+void mul_add_row(uint8_t* dst, const uint8_t* src, uint8_t c, uint32_t len, uint8_t field)
+{
+	if (!c)
+		return;
+	mul_const_t k;
+	prepare_const(k, c, field);
+	row_kernel()(dst, src, k, len, true);
+}
+
+void mul_row(uint8_t* row, uint8_t c, uint32_t len, uint8_t field)
+{
+	mul_const_t k;
+	prepare_const(k, c, field);
+	row_kernel()(row, row, k, len, false);
+}
+
+//
+// Matrices
+//
+
 CMatrix multiply(const CMatrix &m1, const CMatrix &m2, uint8_t field)
 {
 	CMatrix m;
 
-	if (m1.Cols() != m2.Rows() || m1.Rows() != m2.Rows())
+	if (!m1.IsInit() || m1.Cols() != m2.Rows())
 		return m;
 
 	m.Init(m1.Rows(), m2.Cols());
 
+	// Row i of the product is a sum of rows of m2
 	for (uint32_t i = 0; i < m1.Rows(); ++i)
-		for (uint32_t k = 0; k < m2.Cols(); ++k)
-			for (uint32_t j = 0; j < m1.Cols(); ++j)
-				m[i][k] ^= NGF2exp8::gmul_tab(m1[i][j], m2[j][k], field);
+		for (uint32_t j = 0; j < m1.Cols(); ++j)
+			mul_add_row(m[i], m2[j], m1[i][j], m2.Cols(), field);
 
 	return m;
 }
 
+void multiply_vectors(const CMatrix& m, const uint8_t* in, uint8_t* out, uint32_t count, uint8_t field)
+{
+	if (!m.IsInit())
+		return;
+
+	uint32_t rows = m.Rows(), cols = m.Cols();
+
+	std::vector<mul_const_t> k(rows * cols);
+	for (uint32_t i = 0; i < rows; ++i)
+		for (uint32_t j = 0; j < cols; ++j)
+			prepare_const(k[i * cols + j], m[i][j], field);
+
+	// A chunk of vectors is transposed, so coordinate j of all its vectors is one row
+	// and every element of m is applied to the whole chunk at once
+	const uint32_t chunk = 256;
+	std::vector<uint8_t> in_t(cols * chunk), out_t(rows * chunk);
+	row_kernel_t kernel = row_kernel();
+
+	for (uint32_t first = 0; first < count; first += chunk)
+	{
+		uint32_t n = std::min(chunk, count - first);
+		const uint8_t* src = in + (size_t)first * cols;
+		uint8_t* dst = out + (size_t)first * rows;
+
+		for (uint32_t v = 0; v < n; ++v)
+			for (uint32_t j = 0; j < cols; ++j)
+				in_t[j * chunk + v] = src[v * cols + j];
+
+		for (uint32_t i = 0; i < rows; ++i)
+		{
+			uint8_t* row = &out_t[i * chunk];
+			for (uint32_t j = 0; j < cols; ++j)
+				kernel(row, &in_t[j * chunk], k[i * cols + j], n, j != 0);
+		}
+
+		for (uint32_t v = 0; v < n; ++v)
+			for (uint32_t i = 0; i < rows; ++i)
+				dst[v * rows + i] = out_t[i * chunk + v];
+	}
+}
+
+uint32_t eliminate(CMatrix& m, uint8_t field)
+{
+	uint32_t rows = m.Rows(), cols = m.Cols();
+	uint32_t r(0);
+
+	for (uint32_t c = 0; c < cols && r < rows; ++c)
+	{
+		uint32_t p(r);
+		while (p < rows && !m[p][c])
+			++p;
+		if (p == rows)
+			continue;
+
+		if (p != r)
+			std::swap_ranges(m[p], m[p] + cols, m[r]);
+		mul_row(m[r], NGF2exp8::inv_tab(m[r][c], field), cols, field);
+
+		for (uint32_t i = 0; i < rows; ++i)
+		{
+			if (i != r)
+				mul_add_row(m[i], m[r], m[i][c], cols, field);
+		}
+		++r;
+	}
+
+	return r;
+}
+
+uint32_t rank(const CMatrix& m, uint8_t field)
+{
+	if (!m.IsInit())
+		return 0;
+	CMatrix t(m);
+	return eliminate(t, field);
+}
+
+bool inverse(const CMatrix& m, CMatrix& inv, uint8_t field)
+{
+	inv.Release();
+	uint32_t n = m.Rows();
+	if (!m.IsInit() || m.Cols() != n)
+		return false;
+
+	// [m | I] turns into [I | inverse of m]
+	CMatrix t;
+	t.Init(n, 2 * n);
+	for (uint32_t i = 0; i < n; ++i)
+	{
+		std::copy(m[i], m[i] + n, t[i]);
+		t[i][n + i] = 1;
+	}
+
+	// A pivot of a singular m is on the right, so the diagonal ends with zero
+	eliminate(t, field);
+	if (!t[n - 1][n - 1])
+		return false;
+
+	inv.Init(n, n);
+	for (uint32_t i = 0; i < n; ++i)
+		std::copy(t[i] + n, t[i] + 2 * n, inv[i]);
+	return true;
+}
+
 
 CCauchyMatrix::CCauchyMatrix() : m_size(0), m_field(0){}
 CCauchyMatrix::CCauchyMatrix(const CCauchyMatrix &m) : m_size(m.m_size), m_matrix(m.m_matrix), m_init(m.m_init), m_field(m.m_field){}
+CCauchyMatrix::CCauchyMatrix(CCauchyMatrix &&m) noexcept : m_size(m.m_size), m_matrix(std::move(m.m_matrix)), m_init(std::move(m.m_init)), m_field(m.m_field)
+{
+	m.m_size = 0;
+}
 CCauchyMatrix::~CCauchyMatrix(){}
 
 const CCauchyMatrix& CCauchyMatrix::operator=(const CCauchyMatrix& m)
@@ -63,6 +308,17 @@ const CCauchyMatrix& CCauchyMatrix::operator=(const CCauchyMatrix& m)
 	return *this;
 }
 
+CCauchyMatrix& CCauchyMatrix::operator=(CCauchyMatrix&& m) noexcept
+{
+	m_size = m.m_size;
+	m_matrix = std::move(m.m_matrix);
+	m_init = std::move(m.m_init);
+	m_field = m.m_field;
+	m.m_size = 0;
+
+	return *this;
+}
+
 bool CCauchyMatrix::Init(CCauchyMatrix::size_type size, uint8_t field, bool gen_values)
 {
 	if (size < 1 || size > 32)
@@ -173,12 +429,40 @@ void CCauchyMatrix::Inverse(CMatrix& m) const
 
 	m.Init(m_size, m_size);
 
-	uint8_t mul = NGF2exp8::inv_tab(Determinant(), m_field);
+	// The closed form of the inverse of a Cauchy matrix c[i][j] = 1 / (x[i] + y[j]):
+	//   inv[i][j] = e[i] * f[j] * c[j][i], where
+	//   e[i] = prod(y[i] + x[k]) / prod(y[i] + y[k], k != i),
+	//   f[j] = prod(x[j] + y[k]) / prod(x[j] + x[k], k != j).
+	// It takes O(n^2) multiplications instead of a determinant for every element.
+	uint8_t const* x = &m_init[0];
+	uint8_t const* y = &m_init[m_size];
+	uint8_t e[32], f[32];
 
 	for (uint32_t i = 0; i < m_size; ++i)
-		for (uint32_t j = 0; j < m_size; ++j)
-			m[j][i] = NGF2exp8::gmul_tab(mul, Determinant(i, j), m_field);
+	{
+		uint8_t e_num(1), e_den(1), f_num(1), f_den(1);
+		for (uint32_t k = 0; k < m_size; ++k)
+		{
+			e_num = NGF2exp8::gmul_tab(e_num, y[i] ^ x[k], m_field);
+			f_num = NGF2exp8::gmul_tab(f_num, x[i] ^ y[k], m_field);
+			if (k == i)
+				continue;
+			e_den = NGF2exp8::gmul_tab(e_den, y[i] ^ y[k], m_field);
+			f_den = NGF2exp8::gmul_tab(f_den, x[i] ^ x[k], m_field);
+		}
+		e[i] = NGF2exp8::gmul_tab(e_num, NGF2exp8::inv_tab(e_den, m_field), m_field);
+		f[i] = NGF2exp8::gmul_tab(f_num, NGF2exp8::inv_tab(f_den, m_field), m_field);
+	}
 
+	// Row i is f scaled by e[i] and multiplied element-wise by column i of the matrix
+	uint8_t col[32];
+	for (uint32_t i = 0; i < m_size; ++i)
+	{
+		for (uint32_t j = 0; j < m_size; ++j)
+			col[j] = m_matrix[j][i];
+		NGF2exp8::gmul_span(f, e[i], m[i], m_size, m_field);
+		NGF2exp8::gmul_spans(m[i], col, m[i], m_size, m_field);
+	}
 }
 
 };
\ No newline at end of file
@@ -47,7 +47,13 @@ public:
 		Init(m.m_rows, m.m_cols);
 		for (size_type i = 0; i < m_rows; ++i)
 			for (size_type j = 0; j < m_cols; ++j)
-				m_matrix[i * m_rows + j] = m[i][j];
+				m_matrix[i * m_cols + j] = m[i][j];
+	}
+
+	CMatrix(CMatrix&& m) noexcept : m_matrix(m.m_matrix), m_rows(m.m_rows), m_cols(m.m_cols)
+	{
+		m.m_matrix = 0;
+		m.m_rows = m.m_cols = 0;
 	}
 
 	virtual ~CMatrix(){};
@@ -65,7 +71,7 @@ public:
 		m_cols = cols;
 		for (size_type i = 0; i < rows; ++i)
 			for (size_type j = 0; j < cols; ++j)
-				m_matrix[i * rows + j] = 0;
+				m_matrix[i * cols + j] = 0;
 		return true;
 	}
 
@@ -102,19 +108,32 @@ public:
 		Init(m.m_rows, m.m_cols);
 		for (size_type i = 0; i < m_rows; ++i)
 			for (size_type j = 0; j < m_cols; ++j)
-				m_matrix[i * m_rows + j] = m[i][j];
+				m_matrix[i * m_cols + j] = m[i][j];
+
+		return *this;
+	}
 
+	CMatrix& operator=(CMatrix&& m) noexcept
+	{
+		if (this == &m)
+			return *this;
+		Release();
+		m_matrix = m.m_matrix;
+		m_rows = m.m_rows;
+		m_cols = m.m_cols;
+		m.m_matrix = 0;
+		m.m_rows = m.m_cols = 0;
 		return *this;
 	}
 
 	const uint8_t* operator[](size_type i) const
 	{
-		return &m_matrix[m_rows * (i % m_rows)];
+		return &m_matrix[m_cols * (i % m_rows)];
 	}
 
 	uint8_t* operator[](size_type i)
 	{
-		return &m_matrix[m_rows * (i % m_rows)];
+		return &m_matrix[m_cols * (i % m_rows)];
 	}
 
 private:
@@ -133,6 +152,7 @@ public:
 public:
 	CCauchyMatrix();
 	CCauchyMatrix(const CCauchyMatrix& m);
+	CCauchyMatrix(CCauchyMatrix&& m) noexcept;
 	virtual ~CCauchyMatrix();
 
 public:
@@ -168,6 +188,7 @@ public:
 
 public:
 	const CCauchyMatrix& operator=(const CCauchyMatrix& m);
+	CCauchyMatrix& operator=(CCauchyMatrix&& m) noexcept;
 
 	const uint8_t* operator[](size_type i) const
 	{
@@ -207,8 +228,29 @@ private:
 	uint8_t					m_field;
 };
 
+// Rows are contiguous, so every function below works on rows with the vector kernels
+// (PSHUFB with split nibbles, or GF2P8AFFINEQB) when the CPU has them.
+// field is any polynomial of NGF2exp8::get_poly_by_index().
+
+// dst ^= c * src
+void mul_add_row(uint8_t* dst, const uint8_t* src, uint8_t c, uint32_t len, uint8_t field);
+
+// row = c * row
+void mul_row(uint8_t* row, uint8_t c, uint32_t len, uint8_t field);
+
 CMatrix multiply(const CMatrix &m1, const CMatrix &m2, uint8_t field);
 
+// out[k] = m * in[k] for count vectors of m.Cols() bytes, every result has m.Rows() bytes
+void multiply_vectors(const CMatrix& m, const uint8_t* in, uint8_t* out, uint32_t count, uint8_t field);
+
+// Gauss-Jordan elimination to the reduced row echelon form. Returns the rank.
+uint32_t eliminate(CMatrix& m, uint8_t field);
+
+uint32_t rank(const CMatrix& m, uint8_t field);
+
+// Returns false if m is not square or singular
+bool inverse(const CMatrix& m, CMatrix& inv, uint8_t field);
+
 };
 
 #endif // GFMATRIX_H
\ No newline at end of file
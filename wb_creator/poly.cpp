@@ -124,12 +124,8 @@ CPoly mul( CPoly const& p1, CPoly const& p2, uint8_t irr_p )
 
     for( CPoly::size_type i = 0; i < p1.size(); ++i )
     {
-        std::vector<uint8_t> v;
-
-        for( CPoly::size_type j = 0; j < p2.size(); ++j )
-        {
-            v.push_back( NGF2exp8::gmul_tab( p1[i], p2[j], irr_p ) );
-        }
+        std::vector<uint8_t> v( p2.size() );
+        NGF2exp8::gmul_span( p2.data(), p1[i], &v[0], v.size(), irr_p );
         if( i != 0 )
         {
             ret.push( v[v.size() - 1] );
@@ -194,8 +190,7 @@ CPoly normalize( CPoly const& p, uint8_t irr_p )
 
     uint8_t val = NGF2exp8::inv_tab( ret[ret.size() - 1], irr_p );
 
-    for( CPoly::size_type i = 0; i < ret.size(); ++i )
-        ret[i] = NGF2exp8::gmul_tab( ret[i], val, irr_p );
+    NGF2exp8::gmul_span( ret.data(), val, ret.data(), ret.size(), irr_p );
 
     return ret;
 }
@@ -238,8 +233,7 @@ CPoly euclid_algo( CPoly const& p1, CPoly const& p2, uint8_t irr_p )
         return CPoly();
 
     uint8_t val = NGF2exp8::inv_tab( v[0], irr_p );
-    for( CPoly::size_type i = 0; i < d.size(); ++i )
-        d[i] = NGF2exp8::gmul_tab( d[i], val, irr_p ); 
+    NGF2exp8::gmul_span( d.data(), val, d.data(), d.size(), irr_p );
 
     return d;
 }
@@ -247,12 +241,12 @@ CPoly euclid_algo( CPoly const& p1, CPoly const& p2, uint8_t irr_p )
 CPoly create_randomly(uint32_t size, bool nzero, bool volatile_size)
 {
 	CPoly p;
-	for (uint32_t i = 0; i < size; ++i)
+	p.reserve(size);
+	NPrng::fill(p.data(), size);
+	if (nzero)
 	{
-		uint8_t r = NPrng::get_rnd_8();
-		if (nzero)
-			for (; !r; r = NPrng::get_rnd_8()){}
-		p.push(r);
+		for (uint32_t i = 0; i < size; ++i)
+			for (; !p[i]; p[i] = NPrng::get_rnd_8()){}
 	}
 	p.volatile_size(volatile_size);
 	return p;
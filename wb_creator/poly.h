@@ -27,6 +27,7 @@
 
 #include "gf2exp8.h"
 #include <vector>
+#include <utility>
 
 namespace NGFPoly
 {
@@ -46,6 +47,9 @@ public:
 	CPoly(CPoly const& p) : m_v(p.m_v), m_validate_size(p.m_validate_size)
     {}
 
+	CPoly(CPoly&& p) noexcept : m_v(std::move(p.m_v)), m_validate_size(p.m_validate_size)
+    {}
+
 	CPoly(uint8_t val, size_type pos) : m_validate_size(true)
     {
         m_v.resize( pos + 1 );
@@ -82,6 +86,16 @@ public:
         return m_v.size();
     }
 
+    uint8_t const* data() const
+    {
+        return m_v.data();
+    }
+
+    uint8_t* data()
+    {
+        return m_v.data();
+    }
+
     void clear()
     {
         m_v.clear();
@@ -125,6 +139,12 @@ public:
         return *this;
     }
 
+    CPoly& operator =( CPoly&& p ) noexcept
+    {
+        m_v = std::move( p.m_v );
+        return *this;
+    }
+
     bool operator ==( CPoly const& p )
     {
         return m_v == p.m_v;
@@ -1,6 +1,6 @@
 //***************************************************************************************
 // prng.cpp
-// Pseudo random numbers generator (Windows specific)
+// Pseudo random numbers generator
 //
 // Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
 // Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
@@ -22,195 +22,344 @@
 //
 //***************************************************************************************
 #include "prng.h"
-#include <iostream>
+#include <string.h>
+#include <string>
+#include <stdexcept>
 
 #ifdef WIN32
-#pragma comment(lib, "crypt32.lib")
+#pragma comment(lib, "bcrypt.lib")
 #include <Windows.h>
-#include <Wincrypt.h>
+#include <bcrypt.h>
+#else
+#include <sys/random.h>
+#include <errno.h>
 #endif // WIN32
 
 namespace NPrng
 {
 
-mpf_t seed;
+// Fresh bytes of the OS for the seeds and the reseeding of generators: BCryptGenRandom with
+// the system preferred RNG on Windows (CryptGenRandom of the first versions is not used
+// any more), getrandom() elsewhere
+#ifdef WIN32
+static void os_random(void* buf, uint32_t size)
+{
+	// The system RNG needs no handle, so there is no global provider to share
+	if (!BCRYPT_SUCCESS(::BCryptGenRandom(NULL, (PUCHAR)buf, size, BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+		throw std::runtime_error("ERROR: BCryptGenRandom!!!\n");
+}
+
+#else
 
-void iterate_PLCM(mpf_t res, mpf_t x, mpf_t p)
+static void os_random(void* buf, uint32_t size)
 {
-	int cmp_z = mpf_cmp_d(x, 0);
-	int cmp_p = mpf_cmp(x, p);
-	int cmp_half = mpf_cmp_d(x, 0.5);
-	int cmp_1 = mpf_cmp_d(x, 1);
-	if (cmp_z >= 0 && cmp_p <= 0) // 0 <= x <= p
+	for (uint8_t* p = (uint8_t*)buf; size;)
 	{
-		mpf_div(res, x, p);
+		ssize_t n = ::getrandom(p, size, 0);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			throw std::runtime_error("ERROR: getrandom!!!\n");
+		}
+		p += n;
+		size -= (uint32_t)n;
 	}
-	else if (cmp_p && cmp_half <= 0) // p < x <= 0.5
+}
+
+#endif // WIN32
+
+// x = 0.<decimal numbers of the bytes one after another>
+static void chaos_from_bytes(fixed_t& x, uint8_t const buf[32])
+{
+	char t[10];
+	std::string s;
+
+	for (uint32_t i = 0; i < 32; ++i)
 	{
-		mpf_t s1, s2, half_one;
-		mpf_init2(s1, 256);
-		mpf_init2(s2, 256);
-		mpf_init2(half_one, 256);
-		mpf_set_d(half_one, 0.5);
-
-		mpf_sub(s1, x, p);
-		mpf_sub(s2, half_one, p);
-		mpf_div(res, s1, s2);
+		snprintf(t, sizeof(t), "%u", buf[i]);
+		s += t;
 	}
-	else if (cmp_half && cmp_1 <= 0) // 0.5 < x <= 1
+
+	fixed_set_decimal(x, s.c_str());
+}
+
+//
+// ChaCha20
+//
+
+#define CHACHA_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define CHACHA_QR(a, b, c, d)									\
+	a += b; d ^= a; d = CHACHA_ROTL(d, 16);						\
+	c += d; b ^= c; b = CHACHA_ROTL(b, 12);						\
+	a += b; d ^= a; d = CHACHA_ROTL(d, 8);						\
+	c += d; b ^= c; b = CHACHA_ROTL(b, 7);
+
+static void chacha20_block(uint32_t const key[8], uint32_t counter, uint32_t const nonce[3], uint8_t out[64])
+{
+	uint32_t in[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+		key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+		counter, nonce[0], nonce[1], nonce[2] };
+	uint32_t x[16];
+	memcpy(x, in, sizeof(x));
+
+	for (uint32_t i = 0; i < 10; ++i)
 	{
-		mpf_t s1, one;
-		mpf_init2(s1, 256);
-		mpf_init2(one, 256);
-		mpf_set_d(one, 1);
-		mpf_sub(s1, one, x);
-		
-		iterate_PLCM(res, s1, p);
+		CHACHA_QR(x[0], x[4], x[8], x[12]);
+		CHACHA_QR(x[1], x[5], x[9], x[13]);
+		CHACHA_QR(x[2], x[6], x[10], x[14]);
+		CHACHA_QR(x[3], x[7], x[11], x[15]);
+		CHACHA_QR(x[0], x[5], x[10], x[15]);
+		CHACHA_QR(x[1], x[6], x[11], x[12]);
+		CHACHA_QR(x[2], x[7], x[8], x[13]);
+		CHACHA_QR(x[3], x[4], x[9], x[14]);
 	}
 
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		uint32_t v = x[i] + in[i];
+		out[i * 4] = (uint8_t)v;
+		out[i * 4 + 1] = (uint8_t)(v >> 8);
+		out[i * 4 + 2] = (uint8_t)(v >> 16);
+		out[i * 4 + 3] = (uint8_t)(v >> 24);
+	}
 }
 
-#ifdef WIN32
-class CWinSpecificPrngCtx
+#undef CHACHA_QR
+#undef CHACHA_ROTL
+
+// Fast key erasure: every refill of the buffer takes a new key
+// from the beginning of the keystream and erases the old one
+class CDrbg
 {
 public:
-	CWinSpecificPrngCtx()
+	CDrbg() : m_pos(sizeof(m_buf)), m_refills(0)
 	{
-		if ( !::CryptAcquireContext(
-			&m_hCryptProv,
-			NULL,
-			NULL,
-			PROV_RSA_FULL,
-			CRYPT_NEWKEYSET))
-		{
-			DWORD err = ::GetLastError();
-			if (err == NTE_EXISTS)
-			{ 
-				if (!::CryptAcquireContext(
-					&m_hCryptProv,
-					NULL,
-					NULL,
-					PROV_RSA_FULL,
-					CRYPT_DELETEKEYSET))
-				{
-					DWORD err = ::GetLastError();
-					printf("ERROR: CryptAcquireContext!!!\n");
-					exit(err);
-				}
-				if (m_hCryptProv)
-					::CryptReleaseContext(m_hCryptProv, 0);
-
-				if (!::CryptAcquireContext(
-					&m_hCryptProv,
-					NULL,
-					NULL,
-					PROV_RSA_FULL,
-					CRYPT_NEWKEYSET))
-				{
-					DWORD err = ::GetLastError();
-					printf("ERROR: CryptAcquireContext!!!\n");
-					exit(err);
-				}
-			}
-			else
-			{
-				printf("ERROR: CryptAcquireContext!!!\n");
-				exit(err);
-			}
-		}
-
-		mpf_init2(seed, 256);
+		os_random(m_key, sizeof(m_key));
+	}
 
-		uint8_t buf[32];
+	~CDrbg()
+	{
+		volatile uint8_t* p = (volatile uint8_t*)m_buf;
+		for (size_t i = 0; i < sizeof(m_buf); ++i)
+			p[i] = 0;
+	}
 
-		if (!CryptGenRandom(
-			m_hCryptProv,
-			32,
-			(PBYTE)buf))
+	void Fill(void* buf, size_t size)
+	{
+		uint8_t* out = (uint8_t*)buf;
+		while (size)
 		{
-			printf("ERROR: CryptGenRandom!!!\n");
-			DWORD err = ::GetLastError();
-			exit(err);
+			if (m_pos == sizeof(m_buf))
+				Refill();
+
+			size_t n = sizeof(m_buf) - m_pos;
+			if (n > size)
+				n = size;
+			memcpy(out, m_buf + m_pos, n);
+			memset(m_buf + m_pos, 0, n);
+			m_pos += n;
+			out += n;
+			size -= n;
 		}
+	}
 
-		char t[10];
-		std::string s;
+private:
+	CDrbg(CDrbg const&);
+	CDrbg const& operator =(CDrbg const&);
 
-		for (uint32_t i = 0; i < 32; ++i)
+	void Refill()
+	{
+		// The key is mixed with new entropy after every reseed_interval refills
+		if (++m_refills == reseed_interval)
 		{
-			sprintf_s(t, 10, "%u", buf[i]);
-			s += t;
+			uint32_t t[8];
+			os_random(t, sizeof(t));
+			for (uint32_t i = 0; i < 8; ++i)
+				m_key[i] ^= t[i];
+			m_refills = 0;
 		}
-		std::string::iterator it;
-		uint32_t ex = 0;
-		for (it = s.begin(); it != s.end() && ex < 4; ++it, ++ex){}
 
-		s.insert(it, '.');
-		s += "@-4";
-
-		int e = mpf_set_str(seed, s.c_str(), 10);
-		if (e)
-		{
-			printf("ERROR: mpf_set_str!!!\n");
-			exit(e);
-		}
+		static uint32_t const nonce[3] = { 0, 0, 0 };
+		for (uint32_t i = 0; i < sizeof(m_buf) / 64; ++i)
+			chacha20_block(m_key, i, nonce, m_buf + i * 64);
 
+		memcpy(m_key, m_buf, sizeof(m_key));
+		memset(m_buf, 0, sizeof(m_key));
+		m_pos = sizeof(m_key);
 	}
 
-	void get(void* buf, uint32_t size, uint32_t len)
-	{
-		if (size < len)
-			throw std::runtime_error("ERROR: Illegal size!!!\n");
+private:
+	static const uint32_t	reseed_interval = 256;		// 1 MB
+
+	uint32_t	m_key[8];
+	uint8_t		m_buf[4096];
+	size_t		m_pos;
+	uint32_t	m_refills;
+};
+
+// Every thread has its own generator, so they don't share a lock
+static CDrbg& drbg()
+{
+	static thread_local CDrbg g;
+	return g;
+}
+
+// A stream bound to the calling thread by CStreamScope
+static thread_local CStream* g_stream = 0;
+
+//
+// CStream
+//
+
+CStream::CStream(uint8_t const seed[32], uint32_t round, uint32_t direction, uint32_t component) : m_pos(0), m_block_pos((uint64_t)-1)
+{
+	for (uint32_t i = 0; i < 8; ++i)
+		m_key[i] = seed[i * 4] | (seed[i * 4 + 1] << 8) | (seed[i * 4 + 2] << 16) | ((uint32_t)seed[i * 4 + 3] << 24);
+	m_nonce[0] = round;
+	m_nonce[1] = direction;
+	m_nonce[2] = component;
+
+	// The start point of the chaotic map is the beginning of the stream
+	uint8_t buf[32];
+	Fill(buf, sizeof(buf));
+	chaos_from_bytes(m_chaos, buf);
+}
+
+void CStream::Seek(uint64_t pos)
+{
+	if ((pos >> 6) > 0xffffffff)
+		throw std::runtime_error("ERROR: Illegal position in a stream!!!\n");
+	m_pos = pos;
+}
 
-		if (!CryptGenRandom(
-			m_hCryptProv,
-			len,
-			(PBYTE)buf))
+void CStream::Fill(void* buf, size_t size)
+{
+	uint8_t* out = (uint8_t*)buf;
+	while (size)
+	{
+		uint32_t offset = (uint32_t)(m_pos & 63);
+		if (m_pos >> 6 != m_block_pos)
 		{
-			printf("ERROR: CryptGenRandom!!!\n");
-			DWORD err = ::GetLastError();
-			exit(err);
+			if ((m_pos >> 6) > 0xffffffff)
+				throw std::runtime_error("ERROR: The stream is exhausted!!!\n");
+			chacha20_block(m_key, (uint32_t)(m_pos >> 6), m_nonce, m_block);
+			m_block_pos = m_pos >> 6;
 		}
+
+		size_t n = 64 - offset;
+		if (n > size)
+			n = size;
+		memcpy(out, m_block + offset, n);
+		m_pos += n;
+		out += n;
+		size -= n;
 	}
+}
+
+//
+// CContext
+//
+
+CContext::CContext()
+{
+	NewSeed();
+}
+
+CContext::CContext(uint8_t const seed[32])
+{
+	SetSeed(seed);
+}
+
+void CContext::SetSeed(uint8_t const seed[32])
+{
+	memcpy(m_seed, seed, sizeof(m_seed));
+}
+
+void CContext::NewSeed()
+{
+	drbg().Fill(m_seed, sizeof(m_seed));
+}
+
+void CContext::DeriveSeed(uint32_t index, uint8_t seed[32], uint32_t component) const
+{
+	// From the beginning of the stream, the constructor has read it
+	CStream s(m_seed, index, 0, component);
+	s.Seek(0);
+	s.Fill(seed, 32);
+}
 
-	~CWinSpecificPrngCtx()
+//
+// CStreamScope
+//
+
+CStreamScope::CStreamScope(CContext const* ctx, uint32_t round, uint32_t direction, uint32_t component) : m_prev(g_stream)
+{
+	if (ctx)
 	{
-		if (m_hCryptProv)
-			::CryptReleaseContext(m_hCryptProv, 0);
+		m_stream.reset(new CStream(ctx->Seed(), round, direction, component));
+		g_stream = m_stream.get();
 	}
+}
 
-private:
-	HCRYPTPROV   m_hCryptProv;
-};
+CStreamScope::~CStreamScope()
+{
+	g_stream = m_prev;
+}
+
+// The chaotic map of a thread without a stream starts from random bytes of the thread
+static fixed_t& thread_chaos()
+{
+	struct chaos_t
+	{
+		chaos_t()
+		{
+			uint8_t buf[32];
+			drbg().Fill(buf, sizeof(buf));
+			chaos_from_bytes(x, buf);
+		}
 
-CWinSpecificPrngCtx g_win_prng_ctx;
+		fixed_t x;
+	};
 
-#endif // WIN32
+	static thread_local chaos_t c;
+	return c.x;
+}
 
+fixed_t& chaos_state()
+{
+	return g_stream ? g_stream->Chaos() : thread_chaos();
+}
+
+void fill(void* buf, size_t size)
+{
+	if (g_stream)
+		g_stream->Fill(buf, size);
+	else
+		drbg().Fill(buf, size);
+}
 
 void get_rnd_128( void* buf, uint32_t size )
 {
 	if (size != 16)
 		throw std::runtime_error("ERROR: Illegal size!!!\n");
 
-#ifdef WIN32
-	g_win_prng_ctx.get(buf, size, 16);
-#endif // WIN32
+	fill(buf, size);
 }
 
 uint32_t get_rnd_32()
 {
-	
 	uint32_t val;
-#ifdef WIN32
-	g_win_prng_ctx.get(&val, sizeof(val), sizeof(val));
-#endif // WIN32
+	fill(&val, sizeof(val));
 	return val;
 }
 
 uint8_t get_rnd_8()
 {
-	return (uint8_t)get_rnd_32();
+	uint8_t val;
+	fill(&val, sizeof(val));
+	return val;
 }
 
 NGFPoly::CPoly get_rnd_128_poly()
@@ -26,22 +26,106 @@
 #define PRNG_H
 
 #include <stdio.h>
-#include "mpir.h"
+#include "plcm.h"
 #include "poly.h"
 #include <algorithm>
+#include <memory>
 
 
 namespace NPrng
 {
+// Random bytes of a ChaCha20 generator of the calling thread which is reseeded by the OS,
+// or of the stream bound to the thread by CStreamScope
+void fill( void* buf, size_t size );
+
+// Components of a round which have their own streams
+enum stream_component_t
+{
+	rnd_sboxes = 0,		// chaotic s-boxes
+	rnd_mds = 1,		// irreducible polynomial and Cauchy matrix
+	rnd_mixes = 2,		// mixes and additive mask
+	rnd_tables = 3,		// masks of T-boxes
+	rnd_keys = 4,		// master seeds of keys of a batch, the round is the number of a key
+	rnd_devices = 5		// seeds of re-encodings of a key for devices, the round is the number of a device
+};
+
+// Random state of one generator. A key is made of the streams of its master seed only,
+// so every creator owns a context, and creators running at the same time share nothing.
+class CContext
+{
+public:
+	CContext();		// a random master seed
+	explicit CContext(uint8_t const seed[32]);
+
+public:
+	void SetSeed(uint8_t const seed[32]);
+	void NewSeed();
+
+	// The master seed of the key (rnd_keys) or of the device (rnd_devices) with this number
+	void DeriveSeed(uint32_t index, uint8_t seed[32], uint32_t component = rnd_keys) const;
+
+	uint8_t const* Seed() const
+	{
+		return m_seed;
+	}
+
+private:
+	uint8_t		m_seed[32];
+};
+
+// Seeded mode. Every (round, direction, component) takes bytes from its own ChaCha20 stream
+// of a 256-bit master seed. The nonce of a stream is (round, direction, component) and
+// the counter is the number of a block, so a stream may start at any position, and any part
+// of a key can be generated alone, in any order and on any thread.
+class CStream
+{
+public:
+	CStream(uint8_t const seed[32], uint32_t round, uint32_t direction, uint32_t component);
+
+public:
+	void Seek(uint64_t pos);
+	void Fill(void* buf, size_t size);
+
+	// The state of the chaotic map, it starts from the first 32 bytes of the stream
+	fixed_t& Chaos()
+	{
+		return m_chaos;
+	}
+
+private:
+	uint32_t	m_key[8];
+	uint32_t	m_nonce[3];
+	uint64_t	m_pos;
+	uint64_t	m_block_pos;
+	uint8_t		m_block[64];
+	fixed_t		m_chaos;
+};
+
+// Binds a stream of the context to the calling thread until the end of the scope.
+// A null context keeps the current source of random numbers.
+class CStreamScope
+{
+public:
+	CStreamScope(CContext const* ctx, uint32_t round, uint32_t direction, uint32_t component);
+	~CStreamScope();
+
+private:
+	CStreamScope(CStreamScope const&);
+	CStreamScope const& operator =(CStreamScope const&);
+
+private:
+	std::unique_ptr<CStream>	m_stream;
+	CStream*					m_prev;
+};
+
+// The state of the chaotic map of the bound stream, or of the calling thread without a stream
+fixed_t& chaos_state();
+
 void get_rnd_128( void* buf, uint32_t size );
 uint32_t get_rnd_32();
 uint8_t get_rnd_8();
 NGFPoly::CPoly get_rnd_128_poly();
 
-extern mpf_t seed;
-
-void iterate_PLCM(mpf_t res, mpf_t x, mpf_t p);
-
 
 
 template <class T>
@@ -23,6 +23,7 @@
 //***************************************************************************************
 #include "round.h"
 #include "prng.h"
+#include "affine.h"
 
 namespace NWhiteBox
 {
@@ -31,9 +32,9 @@ void InverseSboxes( CRound::s_boxes_t const& s_boxes_in, CRound::s_boxes_t& s_bo
 {
     for( int i = 0; i < 16; ++i )
     {
-        s_boxes_out[( i + ( i % 4 ) * 4 ) % 16].resize( 256, 0 );  // !!!!!!!!!!!!!!!!!!!!!!!!!!
+        CRound::sbox_t& out = s_boxes_out[( i + ( i % 4 ) * 4 ) % 16];
         for( int j = 0; j < 256; ++j )
-            s_boxes_out[( i + ( i % 4 ) * 4 ) % 16].at( s_boxes_in[i].at( j ) ) = (uint8_t)j; // !!!!!!!!!!!!!!!!!!!!!!
+            out[s_boxes_in[i][j]] = (uint8_t)j;
     }
 }
 
@@ -41,29 +42,18 @@ void InverseSboxes( CRound::s_boxes_t const& s_boxes_in, CRound::s_boxes_t& s_bo
 // CRound
 //
 
-CRound::CRound( uint32_t min_mixes_count, uint32_t max_mixes_count, bool is_decr, bool is_last ) : m_is_last( is_last ),
-m_min_mixes_count( min_mixes_count ), m_max_mixes_count( max_mixes_count ), m_is_decr( is_decr )
+CRound::CRound( uint32_t min_mixes_count, uint32_t max_mixes_count, bool is_decr, bool is_last ) : m_irr_p( 0 ), m_is_last( is_last ),
+m_is_decr( is_decr ), m_min_mixes_count( min_mixes_count ), m_max_mixes_count( max_mixes_count ), m_index( 0 ), m_prng( 0 )
 {
 }
 
 CRound::CRound(uint32_t min_mixes_count, uint32_t max_mixes_count, std::vector<mix_t> const& prev_mixes, 
-	const NGFPoly::CPoly& prev_additive_mask, bool is_decr, bool is_last) : m_is_last(is_last),
-m_min_mixes_count( min_mixes_count ), m_max_mixes_count( max_mixes_count ), m_is_decr( is_decr )
+	const NGFPoly::CPoly& prev_additive_mask, bool is_decr, bool is_last) : m_irr_p( 0 ), m_is_last(is_last),
+m_is_decr( is_decr ), m_min_mixes_count( min_mixes_count ), m_max_mixes_count( max_mixes_count ), m_index( 0 ), m_prng( 0 )
 {
 	Init(prev_mixes, prev_additive_mask);
 }
 
-CRound::CRound( CRound const& r ) : /*m_poly( r.m_poly ), m_anti_poly( r.m_anti_poly ),*/ m_irr_p( r.m_irr_p ),
-m_is_last( r.m_is_last ), m_mixes( r.m_mixes ), m_min_mixes_count( r.m_min_mixes_count ), m_max_mixes_count( r.m_max_mixes_count ), 
-m_is_decr(r.m_is_decr), m_additive_mask(r.m_additive_mask), m_mds_matrix(r.m_mds_matrix)
-{
-    for( int i = 0; i < 16; ++i )
-    {
-        m_s_boxes[i] = r.m_s_boxes[i];
-        m_s_boxes_clear[i] = r.m_s_boxes_clear[i];
-    }
-}
-
 CRound::~CRound()
 {
 }
@@ -86,17 +76,9 @@ void CRound::Init(s_boxes_t const& s_boxes_clear, NGFMatrix::CCauchyMatrix const
 void CRound::Init(s_boxes_t const& s_boxes_clear, NGFMatrix::CCauchyMatrix const& m,
 	uint8_t irr_p, std::vector<mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask)
 {
-    // Fill S-boxes
-    for( int i = 0; i < 16; ++i )
-    {
-        m_s_boxes[i] = m_s_boxes_clear[i] = s_boxes_clear[i];
-    }
-
+    SetSboxes( s_boxes_clear );
 	ApplyPrevMixes(prev_mixes, prev_additive_mask);
-
-	m_mds_matrix = m;
-
-    m_irr_p = irr_p;
+    SetMdsMatrix( m, irr_p );
 
     if( m_is_last )
         return;
@@ -104,6 +86,17 @@ void CRound::Init(s_boxes_t const& s_boxes_clear, NGFMatrix::CCauchyMatrix const
     CreateMixes();
 }
 
+void CRound::SetSboxes( s_boxes_t const& s_boxes_clear )
+{
+    m_s_boxes = m_s_boxes_clear = s_boxes_clear;
+}
+
+void CRound::SetMdsMatrix( NGFMatrix::CCauchyMatrix const& m, uint8_t irr_p )
+{
+	m_mds_matrix = m;
+    m_irr_p = irr_p;
+}
+
 void CRound::Clear()
 {
 	m_mds_matrix.Release();
@@ -115,7 +108,8 @@ void CRound::Clear()
 void CRound::Init(std::vector<CRound::mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask)
 {
     Clear();
-	CreateSboxes(prev_mixes, prev_additive_mask);
+	CreateSboxes();
+    ApplyPrevMixes(prev_mixes, prev_additive_mask);
 	CreateMdsMatrix();
     if( m_is_last )
         return;
@@ -123,6 +117,27 @@ void CRound::Init(std::vector<CRound::mix_t> const& prev_mixes, const NGFPoly::C
 }
 
 void CRound::ApplyPrevMixes(std::vector<mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask)
+{
+    if( prev_mixes.empty() )
+    {
+        m_s_boxes = m_s_boxes_clear;
+        return;
+    }
+
+    NGF2exp8::CAffineMap f[16];
+    InputMaps( prev_mixes, prev_additive_mask, f );
+
+    for( int i = 0; i < 16; ++i )
+    {     
+        uint8_t index[256];
+        f[i].CreateTable( index );
+        for( uint32_t j = 0; j < 256; ++j )
+            m_s_boxes[i][index[j]] = m_s_boxes_clear[i][j];
+    }
+}
+
+void CRound::InputMaps( std::vector<mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask,
+    NGF2exp8::CAffineMap f[16] ) const
 {
     class calc_index
     {
@@ -141,34 +156,25 @@ void CRound::ApplyPrevMixes(std::vector<mix_t> const& prev_mixes, const NGFPoly:
     };
     
     
+    // The previous round without mixes leaves the s-boxes as they are
+    for( int i = 0; i < 16; ++i )
+        f[i] = NGF2exp8::CAffineMap();
     if( prev_mixes.empty() )
-    {
-        for( int i = 0; i < 16; ++i )
-        {
-            m_s_boxes[i] = m_s_boxes_clear[i];
-        }
         return;
-    }
 
     calc_index ci( m_is_decr );
 
     for( int i = 0; i < 16; ++i )
     {     
-        for( std::vector<uint8_t>::size_type j = 0; j < 256; ++j )
-        {
-            uint8_t index = (uint8_t)j;
-            for( std::vector<CRound::mix_t>::size_type k = 0; k < prev_mixes.size(); ++k )
-            {    
-				index = NGF2exp8::gmul_tab(index, prev_mixes.at(k)[ci(i)].a, prev_mixes.at(k)[ci(i)].p);
-            }
-			if (prev_additive_mask.size() == 16)
-				index ^= prev_additive_mask[ci(i)];
-            m_s_boxes[i].at( index ) = m_s_boxes_clear[i].at( j );
-        }
+        // The chain of mixes and the mask of a byte is one affine map
+        for( std::vector<CRound::mix_t>::size_type k = 0; k < prev_mixes.size(); ++k )
+            f[i].Mul( prev_mixes[k][ci( i )].a, prev_mixes[k][ci( i )].p );
+        if( prev_additive_mask.size() == 16 )
+            f[i].Xor( prev_additive_mask[ci( i )] );
     }
 }
 
-void CRound::CreateSboxes(std::vector<CRound::mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask)
+void CRound::CreateSboxes()
 {
     // Create S-boxes chaotically
     //for( int i = 0; i < 16; ++i )
@@ -180,16 +186,17 @@ void CRound::CreateSboxes(std::vector<CRound::mix_t> const& prev_mixes, const NG
     //        m_s_boxes_clear[i].push_back( j );
     //    NPrng::shuffle( m_s_boxes_clear[i] );
     //}
+	NPrng::CStreamScope scope(m_prng, m_index, m_is_decr, NPrng::rnd_sboxes);
 	for (int i = 0; i < 16; ++i)
 	{
-		m_s_boxes[i].resize(256);
-		NWhiteBox::create_8bit_sboxes_chaotically(m_s_boxes_clear[i]);
+		m_sbox_chaos[i] = NPrng::chaos_state();
+		NWhiteBox::create_8bit_sboxes_chaotically(m_s_boxes_clear[i].data());
 	}
-    ApplyPrevMixes(prev_mixes, prev_additive_mask);
 }
 
 void CRound::CreateMdsMatrix()
 {
+	NPrng::CStreamScope scope(m_prng, m_index, m_is_decr, NPrng::rnd_mds);
 	m_irr_p = NGF2exp8::get_poly_by_index(NPrng::get_rnd_32() % 30);
 	if (m_is_last)
 		return;
@@ -201,11 +208,14 @@ void CRound::CreateMixes()
     if( !m_max_mixes_count )
         return;
 
+    NPrng::CStreamScope scope( m_prng, m_index, m_is_decr, NPrng::rnd_mixes );
+
     // Create mixes
     uint32_t mixes_num = m_min_mixes_count + 
         ( ( m_min_mixes_count != m_max_mixes_count ) ? ( NPrng::get_rnd_32() %( m_max_mixes_count - m_min_mixes_count ) ) : 0 );
     
     std::vector<uint8_t> v_irr_p;
+    m_mixes.reserve( mixes_num );
 
     for( uint32_t i = 0; i < 30; ++i )
         v_irr_p.push_back( NGF2exp8::get_poly_by_index( i ) );
@@ -230,23 +240,4 @@ void CRound::CreateMixes()
 	m_additive_mask = NGFPoly::create_randomly(16, true, false);
 }
 
-CRound const& CRound::operator =( CRound const& r )
-{
-    for( int i = 0; i < 16; ++i )
-    {
-        m_s_boxes[i] = r.m_s_boxes[i];
-        m_s_boxes_clear[i] = r.m_s_boxes_clear[i];
-    }
-
-	m_mds_matrix = r.m_mds_matrix;
-    m_irr_p = r.m_irr_p;
-    m_is_last = r.m_is_last;
-    m_mixes = r.m_mixes; 
-    m_min_mixes_count = r.m_min_mixes_count;
-    m_max_mixes_count = r.m_max_mixes_count;
-	m_additive_mask = r.m_additive_mask;
-
-    return *this;
-}
-
 }
\ No newline at end of file
@@ -27,8 +27,11 @@
 
 #include "poly.h"
 #include <vector>
+#include <array>
 #include "matrix.h"
 #include "sbox.h"
+#include "prng.h"
+#include "affine.h"
 
 namespace NWhiteBox
 {
@@ -57,13 +60,16 @@ public:
         tuple m_mix[16];
     };
 
-    typedef std::vector<uint8_t>    s_boxes_t[16];
+    // S-boxes of a round lie in one block, so a round needs no allocations for them
+    typedef std::array<uint8_t, 256>    sbox_t;
+    typedef std::array<sbox_t, 16>      s_boxes_t;
 
 public:
     CRound( uint32_t min_mixes_count, uint32_t max_mixes_count, bool is_decr = false, bool is_last = false );
 	CRound(uint32_t min_mixes_count, uint32_t max_mixes_count, std::vector<mix_t> const& prev_mixes, 
 		const NGFPoly::CPoly& prev_additive_mask, bool is_decr = false, bool is_last = false );
-    CRound( CRound const& r );
+    CRound( CRound&& r ) = default;
+    CRound( CRound const& r ) = delete;
     virtual ~CRound();
 
 public:
@@ -75,14 +81,24 @@ public:
         uint8_t irr_p ); 
     void Clear();
 
-private:
+public:
+    // Steps of Init. Each of them changes its own members only, so steps of one round
+    // may run on different threads at the same time. ApplyPrevMixes needs the s-boxes.
+    void CreateSboxes();
+    void CreateMdsMatrix();
     void CreateMixes();
-	void CreateMdsMatrix();
-	void CreateSboxes(std::vector<mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask);
+    void SetSboxes( s_boxes_t const& s_boxes_clear );
+    void SetMdsMatrix( NGFMatrix::CCauchyMatrix const& m, uint8_t irr_p );
 	void ApplyPrevMixes(std::vector<mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask);
 
+    // f[i] is the encoding of input byte i by the mixes and the mask of the previous round,
+    // so s-box i of the round is s(f[i]^-1(x)) for a clear s-box s
+    void InputMaps( std::vector<mix_t> const& prev_mixes, const NGFPoly::CPoly& prev_additive_mask,
+        NGF2exp8::CAffineMap f[16] ) const;
+
 public:
-    CRound const& operator =( CRound const& r );
+    CRound& operator =( CRound&& r ) = default;
+    CRound& operator =( CRound const& r ) = delete;
 
 public:
     s_boxes_t const& GetSboxes() const
@@ -95,6 +111,19 @@ public:
         return m_s_boxes_clear;
     }
 
+    // The start points of the chaotic map of the clear s-boxes made by CreateSboxes
+    NPrng::fixed_t const* GetSboxChaos() const
+    {
+        return m_sbox_chaos;
+    }
+
+    // For s-boxes of another round which are set by SetSboxes
+    void SetSboxChaos( NPrng::fixed_t const chaos[16] )
+    {
+        for( int i = 0; i < 16; ++i )
+            m_sbox_chaos[i] = chaos[i];
+    }
+
 	NGFMatrix::CCauchyMatrix const& GetMdsMatrix() const
 	{
 		return m_mds_matrix;
@@ -150,15 +179,26 @@ public:
         m_is_decr = is_decr;
     }
 
+    // Random numbers of the next Init come from the streams of the context for the round
+    // with this index (see NPrng::CStream). A null context means random numbers of the OS.
+    void SetContext( NPrng::CContext const* ctx, uint32_t index )
+    {
+        m_prng = ctx;
+        m_index = index;
+    }
+
 private:
     s_boxes_t					m_s_boxes;
     s_boxes_t					m_s_boxes_clear;
+    NPrng::fixed_t				m_sbox_chaos[16];
     uint8_t						m_irr_p;
-    std::vector<mix_t>			m_mixes;
     bool						m_is_last; 
+    bool						m_is_decr;
     uint32_t					m_min_mixes_count;
     uint32_t					m_max_mixes_count;
-    bool						m_is_decr;
+    uint32_t					m_index;
+    NPrng::CContext const*		m_prng;
+    std::vector<mix_t>			m_mixes;
 	NGFPoly::CPoly				m_additive_mask;
 	NGFMatrix::CCauchyMatrix	m_mds_matrix;
 };
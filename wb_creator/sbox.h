@@ -33,6 +33,9 @@ namespace NWhiteBox
 
 void create_8bit_sboxes_chaotically(std::vector<uint8_t>&);
 
+// The same into 256 bytes
+void create_8bit_sboxes_chaotically(uint8_t* v);
+
 }
 
 #endif // SBOX_h
\ No newline at end of file
@@ -0,0 +1,118 @@
+//***************************************************************************************
+// taskgraph.cpp
+// Tasks with dependencies run by a thread pool
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_creator.
+//
+// wb_creator is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_creator.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "taskgraph.h"
+#include <deque>
+#include <stdexcept>
+
+namespace NWhiteBox
+{
+
+CTaskGraph::id_t CTaskGraph::Add(task_t const& task)
+{
+	node_t n;
+	n.task = task;
+	n.deps = 0;
+	m_nodes.push_back(n);
+	return m_nodes.size() - 1;
+}
+
+void CTaskGraph::Depends(id_t task, id_t dep)
+{
+	if (task >= m_nodes.size() || dep >= task)
+		throw std::runtime_error("ERROR: Illegal dependency of tasks!!!\n");
+
+	m_nodes[dep].next.push_back(task);
+	++m_nodes[task].deps;
+}
+
+void CTaskGraph::Run(CThreadPool* pool)
+{
+	std::vector<size_t> deps(m_nodes.size());
+	std::deque<id_t> ready;
+	for (id_t i = 0; i < m_nodes.size(); ++i)
+	{
+		deps[i] = m_nodes[i].deps;
+		if (!deps[i])
+			ready.push_back(i);
+	}
+
+	std::mutex lock;
+	std::condition_variable wake;
+	size_t done(0);
+	bool failed(false);
+	std::exception_ptr error;
+
+	// Every thread of the pool takes ready tasks until all of them are done
+	auto worker = [&](size_t)
+	{
+		std::unique_lock<std::mutex> l(lock);
+		for (;;)
+		{
+			while (ready.empty() && done < m_nodes.size() && !failed)
+				wake.wait(l);
+			if (ready.empty())
+				return;
+
+			id_t id = ready.front();
+			ready.pop_front();
+			l.unlock();
+
+			try
+			{
+				m_nodes[id].task();
+			}
+			catch (...)
+			{
+				l.lock();
+				if (!error)
+					error = std::current_exception();
+				failed = true;
+				ready.clear();
+				wake.notify_all();
+				return;
+			}
+
+			l.lock();
+			++done;
+			for (size_t i = 0; i < m_nodes[id].next.size(); ++i)
+			{
+				if (!--deps[m_nodes[id].next[i]])
+					ready.push_back(m_nodes[id].next[i]);
+			}
+			if (!ready.empty() || done == m_nodes.size())
+				wake.notify_all();
+		}
+	};
+
+	if (pool)
+		pool->Run(pool->ThreadsNum(), worker);
+	else
+		worker(0);
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+}
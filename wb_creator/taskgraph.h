@@ -0,0 +1,65 @@
+//***************************************************************************************
+// taskgraph.h
+// Tasks with dependencies run by a thread pool
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_creator.
+//
+// wb_creator is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_creator is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_creator.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include "pool.h"
+#include <vector>
+#include <functional>
+
+namespace NWhiteBox
+{
+
+class CTaskGraph
+{
+public:
+	typedef std::function<void ()>	task_t;
+	typedef size_t					id_t;
+
+public:
+	id_t Add(task_t const& task);
+
+	// task starts after dep has finished. dep must be added before task, so there are no cycles
+	void Depends(id_t task, id_t dep);
+
+	// Runs all tasks on the threads of the pool (on the calling thread if pool is 0).
+	// A task starts as soon as the tasks it depends on have finished. The first exception
+	// thrown by a task is rethrown here, tasks which have not started yet are skipped.
+	void Run(CThreadPool* pool);
+
+private:
+	struct node_t
+	{
+		task_t				task;
+		std::vector<id_t>	next;
+		size_t				deps;
+	};
+
+	std::vector<node_t>	m_nodes;
+};
+
+}
+
+#endif // TASKGRAPH_H
@@ -0,0 +1,167 @@
+//***************************************************************************************
+// cbc.cpp
+// Cipher block chaining (CBC) mode over EVHEN white-box tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "cbc.h"
+#include "kernels.h"
+#include <stdexcept>
+#include <vector>
+
+namespace NWhiteBox
+{
+
+const size_t cbc_chunk_blocks = 4096;							// a range of a stream for one thread
+const size_t cbc_group_streams = 4 * default_batch_blocks;		// streams for one thread
+
+void cbc_encrypt(CTableSet const& t, uint8_t* iv, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (size_t i = 0; i < count; ++i, in += block_size, out += block_size)
+	{
+		uint8_t b[block_size];
+		xor_bytes(in, iv, b, block_size);
+		encrypt_block(t, b, iv);
+		memcpy(out, iv, block_size);
+	}
+}
+
+// prev is the ciphertext block before in[0]. The ciphertext is saved before it is overwritten,
+// so in may be equal to out.
+static void cbc_decrypt_range(CTableSet const& t, uint8_t const* prev, uint8_t const* in, uint8_t* out, size_t count)
+{
+	uint8_t p[block_size];
+	uint8_t b[default_batch_blocks * block_size];
+
+	memcpy(p, prev, block_size);
+
+	for (size_t done = 0; done < count; )
+	{
+		size_t n = (count - done < default_batch_blocks) ? count - done : default_batch_blocks;
+
+		decrypt_blocks_batched(t, in, b, n);
+		for (size_t i = 0; i < n; ++i, in += block_size, out += block_size)
+		{
+			uint8_t c[block_size];
+			memcpy(c, in, block_size);
+			xor_bytes(b + i * block_size, p, out, block_size);
+			memcpy(p, c, block_size);
+		}
+
+		done += n;
+	}
+}
+
+void cbc_decrypt(CTableSet const& t, uint8_t* iv, uint8_t const* in, uint8_t* out, size_t count, CThreadPool* pool)
+{
+	if (!count)
+		return;
+
+	size_t chunks = (count + cbc_chunk_blocks - 1) / cbc_chunk_blocks;
+	uint8_t last[block_size];
+	memcpy(last, in + (count - 1) * block_size, block_size);
+
+	if (!pool || chunks == 1)
+		cbc_decrypt_range(t, iv, in, out, count);
+	else
+	{
+		// The ciphertext blocks before the ranges, they may be overwritten by other threads
+		std::vector<uint8_t> prevs(chunks * block_size);
+		memcpy(&prevs[0], iv, block_size);
+		for (size_t i = 1; i < chunks; ++i)
+			memcpy(&prevs[i * block_size], in + (i * cbc_chunk_blocks - 1) * block_size, block_size);
+
+		pool->Run(chunks, [&](size_t i)
+		{
+			size_t first = i * cbc_chunk_blocks;
+			size_t n = (count - first < cbc_chunk_blocks) ? count - first : cbc_chunk_blocks;
+			cbc_decrypt_range(t, &prevs[i * block_size], in + first * block_size, out + first * block_size, n);
+		});
+	}
+
+	memcpy(iv, last, block_size);
+}
+
+// Lanes of the batch are occupied by streams which have blocks to encrypt
+static void cbc_encrypt_group(CTableSet const& t, cbc_stream_t* streams, size_t num)
+{
+	cbc_stream_t* lane[default_batch_blocks];
+	size_t pos[default_batch_blocks];
+	uint8_t b[default_batch_blocks * block_size];
+	size_t lanes(0), next(0);
+
+	for (;;)
+	{
+		for (; lanes < default_batch_blocks && next < num; ++next)
+		{
+			if (streams[next].count)
+			{
+				lane[lanes] = &streams[next];
+				pos[lanes++] = 0;
+			}
+		}
+		if (!lanes)
+			break;
+
+		for (size_t l = 0; l < lanes; ++l)
+			xor_bytes(lane[l]->in + pos[l] * block_size, lane[l]->iv, b + l * block_size, block_size);
+
+		encrypt_blocks_batched(t, b, b, lanes);
+
+		for (size_t l = 0; l < lanes; )
+		{
+			cbc_stream_t* s = lane[l];
+			memcpy(s->iv, b + l * block_size, block_size);
+			memcpy(s->out + pos[l] * block_size, s->iv, block_size);
+
+			if (++pos[l] < s->count)
+			{
+				++l;
+				continue;
+			}
+
+			// The stream is done, the last lane takes its place
+			--lanes;
+			lane[l] = lane[lanes];
+			pos[l] = pos[lanes];
+			memcpy(b + l * block_size, b + lanes * block_size, block_size);
+		}
+	}
+}
+
+void cbc_encrypt_streams(CTableSet const& t, cbc_stream_t* streams, size_t num, CThreadPool* pool)
+{
+	size_t groups = (num + cbc_group_streams - 1) / cbc_group_streams;
+
+	if (!pool || groups <= 1)
+		cbc_encrypt_group(t, streams, num);
+	else
+	{
+		pool->Run(groups, [&](size_t i)
+		{
+			size_t first = i * cbc_group_streams;
+			size_t n = (num - first < cbc_group_streams) ? num - first : cbc_group_streams;
+			cbc_encrypt_group(t, streams + first, n);
+		});
+	}
+}
+
+}
@@ -0,0 +1,58 @@
+//***************************************************************************************
+// cbc.h
+// Cipher block chaining (CBC) mode over EVHEN white-box tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef CBC_H
+#define CBC_H
+
+#include "engine.h"
+#include "pool.h"
+
+namespace NWhiteBox
+{
+
+// iv is 16 bytes. It is updated to the last ciphertext block, so a stream may be continued
+// by the next call. in may be equal to out.
+
+// Encryption of a stream is sequential: every block depends on the previous one
+void cbc_encrypt(CTableSet const& t, uint8_t* iv, uint8_t const* in, uint8_t* out, size_t count);
+// Decryption of blocks doesn't depend on each other. Ranges of a stream are decrypted by
+// the threads of pool (if it is given) with the batched kernels.
+void cbc_decrypt(CTableSet const& t, uint8_t* iv, uint8_t const* in, uint8_t* out, size_t count, CThreadPool* pool = 0);
+
+struct cbc_stream_t
+{
+	uint8_t			iv[16];
+	uint8_t const*	in;
+	uint8_t*		out;
+	size_t			count;		// of blocks
+};
+
+// Encrypts many independent streams at once. The next blocks of up to default_batch_blocks
+// streams go through the multi-block kernels together, and a finished stream gives its lane
+// to the next one. Groups of streams are processed by the threads of pool.
+void cbc_encrypt_streams(CTableSet const& t, cbc_stream_t* streams, size_t num, CThreadPool* pool = 0);
+
+}
+
+#endif // CBC_H
@@ -0,0 +1,108 @@
+//***************************************************************************************
+// cpu.cpp
+// Detection of instruction sets supported by CPU and OS
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "kernels.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(WB_X86)
+#include <cpuid.h>
+#endif
+
+namespace NWhiteBox
+{
+
+#ifdef WB_X86
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t r[4])
+{
+#if defined(_MSC_VER)
+	__cpuidex((int*)r, (int)leaf, (int)subleaf);
+#else
+	if (!__get_cpuid_count(leaf, subleaf, &r[0], &r[1], &r[2], &r[3]))
+		r[0] = r[1] = r[2] = r[3] = 0;
+#endif
+}
+
+static uint64_t xgetbv0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static uint32_t detect_cpu_features()
+{
+	uint32_t r[4];
+	uint32_t features(0);
+
+	cpuid(0, 0, r);
+	if (r[0] < 7)
+		return 0;
+
+	// SSE forms of SSSE3 and GFNI need no OS support beyond SSE
+	uint32_t leaf1[4];
+	cpuid(1, 0, leaf1);
+	if (leaf1[2] & (1u << 9))
+		features |= wb_cpu_ssse3;
+	cpuid(7, 0, r);
+	if (r[2] & (1u << 8))
+		features |= wb_cpu_gfni;
+
+	// The OS must save YMM (and ZMM) registers on context switches
+	if (!(leaf1[2] & (1u << 27)) || !(leaf1[2] & (1u << 28)))
+		return features;
+	uint64_t xcr0 = xgetbv0();
+	if ((xcr0 & 0x06) != 0x06)
+		return features;
+
+	cpuid(7, 0, r);
+	if (r[1] & (1u << 5))
+		features |= wb_cpu_avx2;
+	if ((r[1] & (1u << 16)) && (xcr0 & 0xe6) == 0xe6)
+		features |= wb_cpu_avx512;
+
+	return features;
+}
+
+uint32_t cpu_features()
+{
+	static uint32_t const features = detect_cpu_features();
+	return features;
+}
+
+#else
+
+uint32_t cpu_features()
+{
+	return 0;
+}
+
+#endif // WB_X86
+
+}
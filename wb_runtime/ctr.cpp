@@ -0,0 +1,149 @@
+//***************************************************************************************
+// ctr.cpp
+// Counter (CTR) mode over EVHEN white-box tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "ctr.h"
+#include "kernels.h"
+#include <string.h>
+#include <stdexcept>
+
+namespace NWhiteBox
+{
+
+// out = ctr + n (128-bit big-endian)
+static void add_counter(uint8_t const* ctr, uint64_t n, uint8_t* out)
+{
+	unsigned carry(0);
+	for (int i = 15; i >= 0; --i)
+	{
+		unsigned sum = ctr[i] + (unsigned)(n & 0xff) + carry;
+		out[i] = (uint8_t)sum;
+		carry = sum >> 8;
+		n >>= 8;
+	}
+}
+
+// Whole blocks starting with the counter ctr. The keystream is made by batches on the stack.
+static void ctr_blocks(CTableSet const& t, uint8_t const* ctr, uint8_t const* in, uint8_t* out, size_t count)
+{
+	uint8_t ks[default_batch_blocks * block_size];
+
+	for (size_t done = 0; done < count; )
+	{
+		size_t n = (count - done < default_batch_blocks) ? count - done : default_batch_blocks;
+
+		for (size_t i = 0; i < n; ++i)
+			add_counter(ctr, done + i, ks + i * block_size);
+		encrypt_blocks_batched(t, ks, ks, n);
+		xor_bytes(in + done * block_size, ks, out + done * block_size, n * block_size);
+
+		done += n;
+	}
+}
+
+//
+// CCtrStream
+//
+
+CCtrStream::CCtrStream(CTableSet const& t, CThreadPool* pool) : m_tables(t), m_pool(pool), m_used(block_size)
+{
+	memset(m_counter, 0, sizeof(m_counter));
+	memset(m_keystream, 0, sizeof(m_keystream));
+}
+
+CCtrStream::~CCtrStream()
+{
+}
+
+void CCtrStream::Init(uint8_t const* nonce)
+{
+	memcpy(m_counter, nonce, sizeof(m_counter));
+	m_used = block_size;
+}
+
+void CCtrStream::Update(uint8_t const* in, uint8_t* out, size_t len)
+{
+	if (!m_tables.IsInit() || m_tables.Direction() != wb_encryption)
+		throw std::runtime_error("ERROR: CTR mode requires public key (encryption tables)!!!\n");
+
+	// The rest of the last keystream block
+	if (m_used < block_size && len)
+	{
+		size_t n = (len < block_size - m_used) ? len : block_size - m_used;
+		xor_bytes(in, m_keystream + m_used, out, n);
+		m_used += n;
+		in += n;
+		out += n;
+		len -= n;
+	}
+
+	size_t count = len / block_size;
+	if (count)
+	{
+		uint8_t const* ctr = m_counter;
+		size_t chunks = (count + ctr_chunk_blocks - 1) / ctr_chunk_blocks;
+
+		if (!m_pool || chunks == 1)
+			ctr_blocks(m_tables, ctr, in, out, count);
+		else
+		{
+			CTableSet const& t = m_tables;
+			m_pool->Run(chunks, [&](size_t i)
+			{
+				size_t first = i * ctr_chunk_blocks;
+				size_t n = (count - first < ctr_chunk_blocks) ? count - first : ctr_chunk_blocks;
+				uint8_t c[16];
+				add_counter(ctr, first, c);
+				ctr_blocks(t, c, in + first * block_size, out + first * block_size, n);
+			});
+		}
+
+		add_counter(m_counter, count, m_counter);
+		in += count * block_size;
+		out += count * block_size;
+		len -= count * block_size;
+	}
+
+	// A partial block: keep its keystream for the next call
+	if (len)
+	{
+		encrypt_block(m_tables, m_counter, m_keystream);
+		add_counter(m_counter, 1, m_counter);
+		xor_bytes(in, m_keystream, out, len);
+		m_used = len;
+	}
+}
+
+void CCtrStream::Encrypt(uint8_t* buf, size_t len, uint8_t const* nonce)
+{
+	Init(nonce);
+	Update(buf, buf, len);
+}
+
+void ctr_encrypt(CTableSet const& t, uint8_t* buf, size_t len, uint8_t const* nonce, CThreadPool* pool)
+{
+	CCtrStream s(t, pool);
+	s.Encrypt(buf, len, nonce);
+}
+
+}
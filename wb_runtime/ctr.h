@@ -0,0 +1,79 @@
+//***************************************************************************************
+// ctr.h
+// Counter (CTR) mode over EVHEN white-box tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef CTR_H
+#define CTR_H
+
+#include "engine.h"
+#include "pool.h"
+
+namespace NWhiteBox
+{
+
+// SECURITY WARNING: CTR gives up the asymmetry of EVHEN. Keystream block i is the encryption
+// of nonce + i (the whole 128-bit block is a big-endian counter), so encryption and decryption
+// are the same operation and both run the encryption tables. Anyone who has the public key
+// (wb_encr_tbl) decrypts any CTR ciphertext. In this mode EVHEN is a symmetric cipher, and its
+// secret is the encryption tables: they must be kept like a private key. The decryption tables
+// are not used at all. Use ECB (engine.h) or CBC (cbc.h) where only the holder of the private
+// key may decrypt.
+// Long buffers are split into ranges of ctr_chunk_blocks counters which are processed by
+// a pool of threads. The result doesn't depend on the number of threads.
+const size_t ctr_chunk_blocks = 4096;		// 64 KB
+
+// A CTR stream. It encrypts and decrypts with the encryption tables, so whoever can encrypt
+// a stream can decrypt it too (see the warning above): t is a symmetric secret here.
+class CCtrStream
+{
+public:
+	// pool may be 0 (all the work is done by the calling thread)
+	explicit CCtrStream(CTableSet const& t, CThreadPool* pool = 0);
+	virtual ~CCtrStream();
+
+public:
+	// Starts a new stream. nonce is 16 bytes.
+	void Init(uint8_t const* nonce);
+	// Encrypts (or decrypts) next len bytes of the stream. in may be equal to out.
+	void Update(uint8_t const* in, uint8_t* out, size_t len);
+	// Init() and Update() of the whole buffer in place
+	void Encrypt(uint8_t* buf, size_t len, uint8_t const* nonce);
+
+private:
+	CCtrStream(CCtrStream const&);
+	CCtrStream const& operator =(CCtrStream const&);
+
+private:
+	CTableSet const&	m_tables;
+	CThreadPool*		m_pool;
+	uint8_t				m_counter[16];		// counter of the next keystream block
+	uint8_t				m_keystream[16];	// the last keystream block
+	size_t				m_used;				// bytes of m_keystream already used
+};
+
+// Encrypts or decrypts the buffer in place with the encryption tables (a symmetric secret, see above)
+void ctr_encrypt(CTableSet const& t, uint8_t* buf, size_t len, uint8_t const* nonce, CThreadPool* pool = 0);
+
+}
+
+#endif // CTR_H
@@ -0,0 +1,280 @@
+//***************************************************************************************
+// engine.cpp
+// Encryption and decryption of 128-bit blocks with EVHEN white-box tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "kernels.h"
+#include <stdexcept>
+#include <vector>
+#include <chrono>
+
+namespace NWhiteBox
+{
+
+bool kernel_supported(kernel_t kernel)
+{
+	switch (kernel)
+	{
+	case wb_kernel_auto:
+	case wb_kernel_scalar:
+	case wb_kernel_scalar_x2:
+	case wb_kernel_scalar_x4:
+	case wb_kernel_scalar_x8:
+		return true;
+#ifdef WB_SSE2
+	case wb_kernel_sse2:
+		return true;
+#endif // WB_SSE2
+#ifdef WB_AVX2
+	case wb_kernel_avx2:
+		return (cpu_features() & wb_cpu_avx2) != 0;
+#endif // WB_AVX2
+#ifdef WB_AVX512
+	case wb_kernel_avx512:
+		return (cpu_features() & wb_cpu_avx512) != 0;
+#endif // WB_AVX512
+	default:
+		return false;
+	}
+}
+
+char const* kernel_name(kernel_t kernel)
+{
+	static char const* const names[wb_kernels_count] = { "auto", "scalar", "scalar_x2", "scalar_x4", "scalar_x8", "sse2", "avx2", "avx512" };
+	return (kernel < wb_kernels_count) ? names[kernel] : "unknown";
+}
+
+template <direction_t D>
+static kernel_t check_args(CTableSet const& t, kernel_t kernel)
+{
+	if (!t.IsInit())
+		throw std::runtime_error("ERROR: Lookup tables are not loaded!!!\n");
+	if (t.Direction() != D)
+		throw std::runtime_error(D == wb_encryption ?
+			"ERROR: Encryption requires public key (encryption tables)!!!\n" :
+			"ERROR: Decryption requires private key (decryption tables)!!!\n");
+
+	// The kernels are timed only when the caller leaves the choice to the library
+	if (kernel == wb_kernel_auto)
+		kernel = best_kernel();
+	else if (!kernel_supported(kernel))
+		throw std::runtime_error("ERROR: The kernel is not supported by this CPU!!!\n");
+
+	return kernel;
+}
+
+template <direction_t D>
+static void run_blocks(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, kernel_t kernel)
+{
+	switch (kernel)
+	{
+	case wb_kernel_scalar_x2:
+		blocks_interleaved<D, 2>(t, in, out, count);
+		break;
+	case wb_kernel_scalar_x4:
+		blocks_interleaved<D, 4>(t, in, out, count);
+		break;
+	case wb_kernel_scalar_x8:
+		blocks_interleaved<D, 8>(t, in, out, count);
+		break;
+#ifdef WB_SSE2
+	case wb_kernel_sse2:
+		blocks_sse2<D>(t, in, out, count);
+		break;
+#endif // WB_SSE2
+#ifdef WB_AVX2
+	case wb_kernel_avx2:
+		blocks_avx2<D>(t, in, out, count);
+		break;
+#endif // WB_AVX2
+#ifdef WB_AVX512
+	case wb_kernel_avx512:
+		blocks_avx512<D>(t, in, out, count);
+		break;
+#endif // WB_AVX512
+	default:
+		blocks_scalar<D>(t, in, out, count);
+		break;
+	}
+}
+
+template <direction_t D>
+static void process_blocks(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, kernel_t kernel)
+{
+	run_blocks<D>(t, in, out, count, check_args<D>(t, kernel));
+}
+
+// The best of a few runs of the kernel over the blocks of buf, in seconds
+static double time_kernel(CTableSet const& t, std::vector<uint8_t>& buf, kernel_t kernel)
+{
+	size_t const count = buf.size() / block_size;
+	double best = 0;
+
+	run_blocks<wb_encryption>(t, &buf[0], &buf[0], count, kernel);
+	for (int i = 0; i < 5; ++i)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		run_blocks<wb_encryption>(t, &buf[0], &buf[0], count, kernel);
+		std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		if (!i || time.count() < best)
+			best = time.count();
+	}
+	return best;
+}
+
+static kernel_t measure_kernels()
+{
+	// Four rounds of random tables (256 KB, more than L2 of many CPUs like the tables of a key)
+	// and 1024 blocks take a few milliseconds for all kernels.
+	uint32_t const rnum = 4;
+	std::vector<uint8_t> tables(rnum * sizeof(round_tbl_t));
+	uint32_t x = 0x9e3779b9;
+	for (size_t i = 0; i < tables.size(); ++i)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		tables[i] = (uint8_t)x;
+	}
+
+	CTableSet t;
+	t.Assign(wb_encryption, &tables[0], rnum);
+	std::vector<uint8_t> buf(1024 * block_size);
+	for (size_t i = 0; i < buf.size(); ++i)
+		buf[i] = tables[i * 61 % tables.size()];
+
+	// On a tie the kernel listed first wins
+	static kernel_t const candidates[] = { wb_kernel_scalar_x8, wb_kernel_sse2, wb_kernel_avx2, wb_kernel_avx512 };
+	kernel_t best = wb_kernel_scalar_x8;
+	double best_time = time_kernel(t, buf, best);
+	for (size_t i = 1; i < sizeof(candidates) / sizeof(candidates[0]); ++i)
+	{
+		if (!kernel_supported(candidates[i]))
+			continue;
+
+		double time = time_kernel(t, buf, candidates[i]);
+		if (time < best_time)
+		{
+			best = candidates[i];
+			best_time = time;
+		}
+	}
+	return best;
+}
+
+kernel_t best_kernel()
+{
+	// Which kernel wins depends on the CPU: gathers are microcoded on some of them and each one
+	// touches 8 or 16 cache lines, while eight interleaved scalar blocks hide the latencies of
+	// lookups well everywhere. So the kernels are timed once, at the first call.
+	static kernel_t const best = measure_kernels();
+	return best;
+}
+
+template <direction_t D>
+static round_blocks_t round_kernel(kernel_t kernel)
+{
+	switch (kernel)
+	{
+	case wb_kernel_scalar_x2:
+		return round_blocks_interleaved<D, 2>;
+	case wb_kernel_scalar_x4:
+		return round_blocks_interleaved<D, 4>;
+	case wb_kernel_scalar_x8:
+		return round_blocks_interleaved<D, 8>;
+#ifdef WB_SSE2
+	case wb_kernel_sse2:
+		return round_blocks_sse2<D>;
+#endif // WB_SSE2
+#ifdef WB_AVX2
+	case wb_kernel_avx2:
+		return round_blocks_avx2<D>;
+#endif // WB_AVX2
+#ifdef WB_AVX512
+	case wb_kernel_avx512:
+		return round_blocks_avx512<D>;
+#endif // WB_AVX512
+	default:
+		return round_blocks_scalar<D>;
+	}
+}
+
+// Round-major order: a round is applied to the whole batch before the next one, so only
+// the tables of one round (64 KB) are used at a time. The state of the batch lives in out.
+template <direction_t D>
+static void process_batched(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, size_t batch, kernel_t kernel)
+{
+	round_blocks_t round = round_kernel<D>(check_args<D>(t, kernel));
+	if (!batch)
+		throw std::runtime_error("ERROR: Illegal batch size!!!\n");
+
+	round_ptr_t const* rounds = t.Rounds();
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	while (count)
+	{
+		size_t n = (count < batch) ? count : batch;
+
+		round(rounds[0], in, out, n);
+		for (uint32_t r = 1; r < rnum; ++r)
+			round(rounds[r], out, out, n);
+		if (final)
+			round_blocks_final<D>(final, out, out, n);
+
+		in += n * block_size;
+		out += n * block_size;
+		count -= n;
+	}
+}
+
+void encrypt_block(CTableSet const& t, uint8_t const* in, uint8_t* out)
+{
+	process_blocks<wb_encryption>(t, in, out, 1, wb_kernel_scalar);
+}
+
+void decrypt_block(CTableSet const& t, uint8_t const* in, uint8_t* out)
+{
+	process_blocks<wb_decryption>(t, in, out, 1, wb_kernel_scalar);
+}
+
+void encrypt_blocks(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, kernel_t kernel)
+{
+	process_blocks<wb_encryption>(t, in, out, count, kernel);
+}
+
+void decrypt_blocks(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, kernel_t kernel)
+{
+	process_blocks<wb_decryption>(t, in, out, count, kernel);
+}
+
+void encrypt_blocks_batched(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, size_t batch, kernel_t kernel)
+{
+	process_batched<wb_encryption>(t, in, out, count, batch, kernel);
+}
+
+void decrypt_blocks_batched(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, size_t batch, kernel_t kernel)
+{
+	process_batched<wb_decryption>(t, in, out, count, batch, kernel);
+}
+
+}
@@ -0,0 +1,72 @@
+//***************************************************************************************
+// engine.h
+// Encryption and decryption of 128-bit blocks with EVHEN white-box tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "tables.h"
+
+namespace NWhiteBox
+{
+
+const size_t block_size = 16;
+const size_t default_batch_blocks = 64;		// 1 KB of state next to 64 KB of tables of one round
+
+enum kernel_t
+{
+	wb_kernel_auto = 0,		// the fastest one supported by CPU
+	wb_kernel_scalar,		// portable, 32-bit loads (like encr_r/decr_r macros of the first wb_sample)
+	wb_kernel_scalar_x2,	// the same code for 2, 4 or 8 interleaved blocks (independent chains of lookups)
+	wb_kernel_scalar_x4,
+	wb_kernel_scalar_x8,
+	wb_kernel_sse2,			// whole T-box entries, the state is kept in a XMM register
+	wb_kernel_avx2,			// 8 blocks at once, 32-bit gathers from T-boxes
+	wb_kernel_avx512,		// 16 blocks at once, 32-bit gathers from T-boxes
+	wb_kernels_count
+};
+
+bool kernel_supported(kernel_t kernel);
+// The kernel of wb_kernel_auto: the fastest one of a short measurement at the first call
+kernel_t best_kernel();
+char const* kernel_name(kernel_t kernel);
+
+// in and out may point to the same buffer. A single block takes the scalar kernel,
+// the others gain nothing on it.
+void encrypt_block(CTableSet const& t, uint8_t const* in, uint8_t* out);
+void decrypt_block(CTableSet const& t, uint8_t const* in, uint8_t* out);
+
+// ECB over count consecutive blocks
+void encrypt_blocks(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, kernel_t kernel = wb_kernel_auto);
+void decrypt_blocks(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count, kernel_t kernel = wb_kernel_auto);
+
+// The same in round-major order: every round is applied to batch blocks before the next one,
+// so the tables of one round stay in cache. The result is identical to encrypt/decrypt_blocks.
+void encrypt_blocks_batched(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count,
+	size_t batch = default_batch_blocks, kernel_t kernel = wb_kernel_auto);
+void decrypt_blocks_batched(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count,
+	size_t batch = default_batch_blocks, kernel_t kernel = wb_kernel_auto);
+
+}
+
+#endif // ENGINE_H
@@ -0,0 +1,145 @@
+//***************************************************************************************
+// kernel_avx2.cpp
+// AVX2 kernel of the EVHEN runtime (8 blocks at once)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "kernels.h"
+
+#ifdef WB_AVX2
+
+#include <immintrin.h>
+
+namespace NWhiteBox
+{
+
+// Eight blocks are processed at once. The state is transposed, so s[w] holds the w-th 32-bit
+// word of every block, and vpgatherdd looks up the same T-box of a round for all blocks.
+
+// 4x4 transpose of 32-bit words inside every 128-bit lane. It is its own inverse.
+WB_TARGET_AVX2
+static inline void transpose_avx2(__m256i s[4])
+{
+	__m256i t0 = _mm256_unpacklo_epi32(s[0], s[1]);
+	__m256i t1 = _mm256_unpacklo_epi32(s[2], s[3]);
+	__m256i t2 = _mm256_unpackhi_epi32(s[0], s[1]);
+	__m256i t3 = _mm256_unpackhi_epi32(s[2], s[3]);
+	s[0] = _mm256_unpacklo_epi64(t0, t1);
+	s[1] = _mm256_unpackhi_epi64(t0, t1);
+	s[2] = _mm256_unpacklo_epi64(t2, t3);
+	s[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+// Index of a T-box entry in 32-bit words: byte i of the state multiplied by 4
+WB_TARGET_AVX2
+static inline __m256i entry_index_avx2(__m256i const s[4], int i)
+{
+	__m256i const mask = _mm256_set1_epi32(0x3fc);
+	int shift = (i & 3) * 8;
+	__m256i w = s[i >> 2];
+	return _mm256_and_si256(shift ? _mm256_srli_epi32(w, shift - 2) : _mm256_slli_epi32(w, 2), mask);
+}
+
+template <direction_t D>
+WB_TARGET_AVX2
+static inline void round_avx2(round_ptr_t t, __m256i s[4])
+{
+	__m256i x[4];
+
+	for (int j = 0; j < 16; ++j)
+	{
+		__m256i idx = entry_index_avx2(s, round_input_order[D][j]);
+		int const* e = (int const*)t[j][0];
+
+		if (!j)
+		{
+			for (int w = 0; w < 4; ++w)
+				x[w] = _mm256_i32gather_epi32(e + w, idx, 4);
+		}
+		else
+		{
+			for (int w = 0; w < 4; ++w)
+				x[w] = _mm256_xor_si256(x[w], _mm256_i32gather_epi32(e + w, idx, 4));
+		}
+	}
+
+	for (int w = 0; w < 4; ++w)
+		s[w] = x[w];
+}
+
+template <direction_t D>
+WB_TARGET_AVX2
+void blocks_avx2(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	round_ptr_t const* rounds = t.Rounds();
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	for (; count >= 8; count -= 8, in += 8 * block_size, out += 8 * block_size)
+	{
+		__m256i s[4];
+		for (int i = 0; i < 4; ++i)
+			s[i] = _mm256_loadu_si256((__m256i const*)(in + 32 * i));
+		transpose_avx2(s);
+
+		for (uint32_t r = 0; r < rnum; ++r)
+			round_avx2<D>(rounds[r], s);
+
+		transpose_avx2(s);
+		for (int i = 0; i < 4; ++i)
+			_mm256_storeu_si256((__m256i*)(out + 32 * i), s[i]);
+
+		if (final)
+			round_blocks_final<D>(final, out, out, 8);
+	}
+
+	if (count)
+		blocks_sse2<D>(t, in, out, count);
+}
+
+template <direction_t D>
+WB_TARGET_AVX2
+void round_blocks_avx2(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (; count >= 8; count -= 8, in += 8 * block_size, out += 8 * block_size)
+	{
+		__m256i s[4];
+		for (int i = 0; i < 4; ++i)
+			s[i] = _mm256_loadu_si256((__m256i const*)(in + 32 * i));
+		transpose_avx2(s);
+		round_avx2<D>(t, s);
+		transpose_avx2(s);
+		for (int i = 0; i < 4; ++i)
+			_mm256_storeu_si256((__m256i*)(out + 32 * i), s[i]);
+	}
+
+	if (count)
+		round_blocks_sse2<D>(t, in, out, count);
+}
+
+template void blocks_avx2<wb_encryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void blocks_avx2<wb_decryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_avx2<wb_encryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_avx2<wb_decryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+
+}
+
+#endif // WB_AVX2
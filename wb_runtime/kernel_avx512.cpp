@@ -0,0 +1,147 @@
+//***************************************************************************************
+// kernel_avx512.cpp
+// AVX-512 kernel of the EVHEN runtime (16 blocks at once)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "kernels.h"
+
+#ifdef WB_AVX512
+
+#include <immintrin.h>
+
+namespace NWhiteBox
+{
+
+// The same scheme as in kernel_avx2.cpp with sixteen blocks in ZMM registers.
+// GCC implements the unmasked AVX-512 intrinsics with an undefined source operand and warns
+// about it (-Wmaybe-uninitialized), so the zero-masked forms with all lanes enabled are used.
+// They compile to the same instructions.
+
+static __mmask16 const all_lanes = 0xffff;
+
+WB_TARGET_AVX512
+static inline void transpose_avx512(__m512i s[4])
+{
+	__m512i t0 = _mm512_maskz_unpacklo_epi32(all_lanes, s[0], s[1]);
+	__m512i t1 = _mm512_maskz_unpacklo_epi32(all_lanes, s[2], s[3]);
+	__m512i t2 = _mm512_maskz_unpackhi_epi32(all_lanes, s[0], s[1]);
+	__m512i t3 = _mm512_maskz_unpackhi_epi32(all_lanes, s[2], s[3]);
+	s[0] = _mm512_maskz_unpacklo_epi64((__mmask8)all_lanes, t0, t1);
+	s[1] = _mm512_maskz_unpackhi_epi64((__mmask8)all_lanes, t0, t1);
+	s[2] = _mm512_maskz_unpacklo_epi64((__mmask8)all_lanes, t2, t3);
+	s[3] = _mm512_maskz_unpackhi_epi64((__mmask8)all_lanes, t2, t3);
+}
+
+WB_TARGET_AVX512
+static inline __m512i entry_index_avx512(__m512i const s[4], int i)
+{
+	__m512i const mask = _mm512_set1_epi32(0x3fc);
+	int shift = (i & 3) * 8;
+	__m512i w = s[i >> 2];
+	return _mm512_and_si512(shift ? _mm512_maskz_srli_epi32(all_lanes, w, shift - 2) : _mm512_maskz_slli_epi32(all_lanes, w, 2), mask);
+}
+
+template <direction_t D>
+WB_TARGET_AVX512
+static inline void round_avx512(round_ptr_t t, __m512i s[4])
+{
+	__m512i x[4];
+
+	for (int j = 0; j < 16; ++j)
+	{
+		__m512i idx = entry_index_avx512(s, round_input_order[D][j]);
+		int const* e = (int const*)t[j][0];
+
+		if (!j)
+		{
+			for (int w = 0; w < 4; ++w)
+				x[w] = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), all_lanes, idx, e + w, 4);
+		}
+		else
+		{
+			for (int w = 0; w < 4; ++w)
+				x[w] = _mm512_xor_si512(x[w], _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), all_lanes, idx, e + w, 4));
+		}
+	}
+
+	for (int w = 0; w < 4; ++w)
+		s[w] = x[w];
+}
+
+template <direction_t D>
+WB_TARGET_AVX512
+void blocks_avx512(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	round_ptr_t const* rounds = t.Rounds();
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	for (; count >= 16; count -= 16, in += 16 * block_size, out += 16 * block_size)
+	{
+		__m512i s[4];
+		for (int i = 0; i < 4; ++i)
+			s[i] = _mm512_loadu_si512((void const*)(in + 64 * i));
+		transpose_avx512(s);
+
+		for (uint32_t r = 0; r < rnum; ++r)
+			round_avx512<D>(rounds[r], s);
+
+		transpose_avx512(s);
+		for (int i = 0; i < 4; ++i)
+			_mm512_storeu_si512((void*)(out + 64 * i), s[i]);
+
+		if (final)
+			round_blocks_final<D>(final, out, out, 16);
+	}
+
+	if (count)
+		blocks_avx2<D>(t, in, out, count);
+}
+
+template <direction_t D>
+WB_TARGET_AVX512
+void round_blocks_avx512(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (; count >= 16; count -= 16, in += 16 * block_size, out += 16 * block_size)
+	{
+		__m512i s[4];
+		for (int i = 0; i < 4; ++i)
+			s[i] = _mm512_loadu_si512((void const*)(in + 64 * i));
+		transpose_avx512(s);
+		round_avx512<D>(t, s);
+		transpose_avx512(s);
+		for (int i = 0; i < 4; ++i)
+			_mm512_storeu_si512((void*)(out + 64 * i), s[i]);
+	}
+
+	if (count)
+		round_blocks_avx2<D>(t, in, out, count);
+}
+
+template void blocks_avx512<wb_encryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void blocks_avx512<wb_decryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_avx512<wb_encryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_avx512<wb_decryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+
+}
+
+#endif // WB_AVX512
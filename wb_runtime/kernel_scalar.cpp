@@ -0,0 +1,188 @@
+//***************************************************************************************
+// kernel_scalar.cpp
+// Portable kernel of the EVHEN runtime
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "kernels.h"
+#include <string.h>
+
+namespace NWhiteBox
+{
+
+// One round: every output word is a XOR of the same words of 16 T-box entries.
+// The direction is a template parameter so the input byte order is folded into constant offsets.
+template <direction_t D>
+static inline void round_scalar(round_ptr_t t, uint32_t const* bi, uint32_t* bo)
+{
+	uint8_t const* b = (uint8_t const*)bi;
+	uint32_t w0(0), w1(0), w2(0), w3(0);
+
+	for (int j = 0; j < 16; ++j)
+	{
+		uint32_t const* e = (uint32_t const*)t[j][b[round_input_order[D][j]]];
+		w0 ^= e[0];
+		w1 ^= e[1];
+		w2 ^= e[2];
+		w3 ^= e[3];
+	}
+
+	bo[0] = w0;
+	bo[1] = w1;
+	bo[2] = w2;
+	bo[3] = w3;
+}
+
+template <direction_t D>
+void blocks_scalar(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	round_ptr_t const* rounds = t.Rounds();
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	for (size_t n = 0; n < count; ++n, in += block_size, out += block_size)
+	{
+		uint32_t b[2][4];
+		memcpy(b[0], in, block_size);
+
+		for (uint32_t r = 0; r < rnum; ++r)
+			round_scalar<D>(rounds[r], b[r & 1], b[(r + 1) & 1]);
+
+		if (final)
+			final_round<D>(final, (uint8_t const*)b[rnum & 1], out);
+		else
+			memcpy(out, b[rnum & 1], block_size);
+	}
+}
+
+template <direction_t D>
+void round_blocks_scalar(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (size_t n = 0; n < count; ++n, in += block_size, out += block_size)
+	{
+		uint32_t b[2][4];
+		memcpy(b[0], in, block_size);
+		round_scalar<D>(t, b[0], b[1]);
+		memcpy(out, b[1], block_size);
+	}
+}
+
+// N independent blocks go through a round together. Lookups of different blocks don't depend
+// on each other, so their cache misses overlap instead of forming one chain of 16 loads.
+template <direction_t D, int N>
+static inline void round_interleaved(round_ptr_t t, uint32_t const (*bi)[4], uint32_t (*bo)[4])
+{
+	uint32_t w[N][4];
+	memset(w, 0, sizeof(w));
+
+	// Loops over T-boxes and blocks are unrolled by hand, compilers don't do it at /O2.
+	// Lanes n >= N are removed as dead code.
+#define WB_LANE(j, n)																		\
+	if (n < N)																				\
+	{																						\
+		uint32_t const* e = (uint32_t const*)t[j][((uint8_t const*)bi[n])[round_input_order[D][j]]];	\
+		w[n][0] ^= e[0];																	\
+		w[n][1] ^= e[1];																	\
+		w[n][2] ^= e[2];																	\
+		w[n][3] ^= e[3];																	\
+	}
+#define WB_LOOKUP(j)	\
+	WB_LANE(j, 0) WB_LANE(j, 1) WB_LANE(j, 2) WB_LANE(j, 3) WB_LANE(j, 4) WB_LANE(j, 5) WB_LANE(j, 6) WB_LANE(j, 7)
+
+	WB_LOOKUP(0) WB_LOOKUP(1) WB_LOOKUP(2) WB_LOOKUP(3)
+	WB_LOOKUP(4) WB_LOOKUP(5) WB_LOOKUP(6) WB_LOOKUP(7)
+	WB_LOOKUP(8) WB_LOOKUP(9) WB_LOOKUP(10) WB_LOOKUP(11)
+	WB_LOOKUP(12) WB_LOOKUP(13) WB_LOOKUP(14) WB_LOOKUP(15)
+
+#undef WB_LOOKUP
+#undef WB_LANE
+
+	memcpy(bo, w, sizeof(w));
+}
+
+template <direction_t D, int N>
+void blocks_interleaved(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	round_ptr_t const* rounds = t.Rounds();
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	for (; count >= N; count -= N, in += N * block_size, out += N * block_size)
+	{
+		uint32_t b[2][N][4];
+		memcpy(b[0], in, N * block_size);
+
+		for (uint32_t r = 0; r < rnum; ++r)
+			round_interleaved<D, N>(rounds[r], b[r & 1], b[(r + 1) & 1]);
+
+		if (final)
+		{
+			for (int n = 0; n < N; ++n)
+				final_round<D>(final, (uint8_t const*)b[rnum & 1][n], out + n * block_size);
+		}
+		else
+			memcpy(out, b[rnum & 1], N * block_size);
+	}
+
+	if (count)
+		blocks_scalar<D>(t, in, out, count);
+}
+
+template <direction_t D, int N>
+void round_blocks_interleaved(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (; count >= N; count -= N, in += N * block_size, out += N * block_size)
+	{
+		uint32_t b[2][N][4];
+		memcpy(b[0], in, N * block_size);
+		round_interleaved<D, N>(t, b[0], b[1]);
+		memcpy(out, b[1], N * block_size);
+	}
+
+	if (count)
+		round_blocks_scalar<D>(t, in, out, count);
+}
+
+template <direction_t D>
+void round_blocks_final(sbox_ptr_t s, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (size_t n = 0; n < count; ++n, in += block_size, out += block_size)
+		final_round<D>(s, in, out);
+}
+
+template void blocks_scalar<wb_encryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void blocks_scalar<wb_decryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_scalar<wb_encryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_scalar<wb_decryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_final<wb_encryption>(sbox_ptr_t, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_final<wb_decryption>(sbox_ptr_t, uint8_t const*, uint8_t*, size_t);
+
+#define WB_INSTANTIATE_INTERLEAVED(N)																\
+	template void blocks_interleaved<wb_encryption, N>(CTableSet const&, uint8_t const*, uint8_t*, size_t);	\
+	template void blocks_interleaved<wb_decryption, N>(CTableSet const&, uint8_t const*, uint8_t*, size_t);	\
+	template void round_blocks_interleaved<wb_encryption, N>(round_ptr_t, uint8_t const*, uint8_t*, size_t);	\
+	template void round_blocks_interleaved<wb_decryption, N>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+
+WB_INSTANTIATE_INTERLEAVED(2)
+WB_INSTANTIATE_INTERLEAVED(4)
+WB_INSTANTIATE_INTERLEAVED(8)
+
+}
@@ -0,0 +1,114 @@
+//***************************************************************************************
+// kernel_sse2.cpp
+// SSE2 kernel of the EVHEN runtime
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "kernels.h"
+
+#ifdef WB_SSE2
+
+#include <emmintrin.h>
+
+namespace NWhiteBox
+{
+
+// The state of a block stays in a XMM register during all rounds. Its bytes are moved to
+// general purpose registers (no memory round trip) and every T-box entry is loaded at once,
+// i.e. a round takes 16 loads instead of 64 loads of 32-bit words.
+#if defined(_M_X64) || defined(__x86_64__)
+
+#define WB_STATE_TO_GPR(s, w)								\
+	uint64_t w[2] = { (uint64_t)_mm_cvtsi128_si64(s),		\
+		(uint64_t)_mm_cvtsi128_si64(_mm_srli_si128(s, 8)) };
+#define WB_STATE_BYTE(w, i)		(uint8_t)(w[(i) >> 3] >> (((i) & 7) * 8))
+
+#else
+
+#define WB_STATE_TO_GPR(s, w)								\
+	uint32_t w[4] = { (uint32_t)_mm_cvtsi128_si32(s),		\
+		(uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 4)),	\
+		(uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 8)),	\
+		(uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 12)) };
+#define WB_STATE_BYTE(w, i)		(uint8_t)(w[(i) >> 2] >> (((i) & 3) * 8))
+
+#endif
+
+#define WB_TBOX(t, w, j)		_mm_loadu_si128((__m128i const*)t[j][WB_STATE_BYTE(w, round_input_order[D][j])])
+
+template <direction_t D>
+static inline __m128i round_sse2(round_ptr_t t, __m128i s)
+{
+	WB_STATE_TO_GPR(s, w);
+
+	// Four independent chains of XORs
+	__m128i x0 = _mm_xor_si128(WB_TBOX(t, w, 0), WB_TBOX(t, w, 1));
+	__m128i x1 = _mm_xor_si128(WB_TBOX(t, w, 2), WB_TBOX(t, w, 3));
+	__m128i x2 = _mm_xor_si128(WB_TBOX(t, w, 4), WB_TBOX(t, w, 5));
+	__m128i x3 = _mm_xor_si128(WB_TBOX(t, w, 6), WB_TBOX(t, w, 7));
+	x0 = _mm_xor_si128(x0, _mm_xor_si128(WB_TBOX(t, w, 8), WB_TBOX(t, w, 9)));
+	x1 = _mm_xor_si128(x1, _mm_xor_si128(WB_TBOX(t, w, 10), WB_TBOX(t, w, 11)));
+	x2 = _mm_xor_si128(x2, _mm_xor_si128(WB_TBOX(t, w, 12), WB_TBOX(t, w, 13)));
+	x3 = _mm_xor_si128(x3, _mm_xor_si128(WB_TBOX(t, w, 14), WB_TBOX(t, w, 15)));
+
+	return _mm_xor_si128(_mm_xor_si128(x0, x1), _mm_xor_si128(x2, x3));
+}
+
+template <direction_t D>
+void blocks_sse2(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	round_ptr_t const* rounds = t.Rounds();
+	uint32_t rnum = t.TboxRoundsNum();
+	sbox_ptr_t final = t.FinalSbox();
+
+	for (size_t n = 0; n < count; ++n, in += block_size, out += block_size)
+	{
+		__m128i s = _mm_loadu_si128((__m128i const*)in);
+
+		for (uint32_t r = 0; r < rnum; ++r)
+			s = round_sse2<D>(rounds[r], s);
+
+		if (final)
+		{
+			WB_STATE_TO_GPR(s, w);
+			for (int j = 0; j < 16; ++j)
+				out[j] = final[j][WB_STATE_BYTE(w, round_input_order[D][j])];
+		}
+		else
+			_mm_storeu_si128((__m128i*)out, s);
+	}
+}
+
+template <direction_t D>
+void round_blocks_sse2(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count)
+{
+	for (size_t n = 0; n < count; ++n, in += block_size, out += block_size)
+		_mm_storeu_si128((__m128i*)out, round_sse2<D>(t, _mm_loadu_si128((__m128i const*)in)));
+}
+
+template void blocks_sse2<wb_encryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void blocks_sse2<wb_decryption>(CTableSet const&, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_sse2<wb_encryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+template void round_blocks_sse2<wb_decryption>(round_ptr_t, uint8_t const*, uint8_t*, size_t);
+
+}
+
+#endif // WB_SSE2
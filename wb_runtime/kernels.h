@@ -0,0 +1,153 @@
+//***************************************************************************************
+// kernels.h
+// Kernels of the EVHEN runtime (internal header of wb_runtime)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "engine.h"
+#include <string.h>
+
+// SSE2 is a baseline of x86-64 and the default target of Win32 builds since Visual Studio 2012
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define WB_SSE2
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WB_X86
+#endif
+
+// AVX2 and AVX-512 kernels are compiled without global compiler flags and are called only when
+// cpu_features() reports the instruction set. GCC and Clang need a target attribute for that,
+// and it must be the same in the declaration and the definition.
+#if defined(WB_X86) && defined(WB_SSE2) && (defined(_MSC_VER) || defined(__GNUC__))
+#define WB_AVX2
+#if !defined(_MSC_VER) || _MSC_VER >= 1911
+#define WB_AVX512
+#endif
+#endif
+
+// PSHUFB and GF2P8AFFINEQB (wb_creator uses them for GF(2^8) arithmetic)
+#if defined(WB_AVX2)
+#define WB_SSSE3
+#endif
+#if defined(WB_X86) && defined(WB_SSE2) && ((defined(_MSC_VER) && _MSC_VER >= 1920) || \
+	(defined(__clang__) && __clang_major__ >= 6) || (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8))
+#define WB_GFNI
+#endif
+
+#if defined(__GNUC__)
+#define WB_TARGET_AVX2		__attribute__((target("avx2")))
+#define WB_TARGET_AVX512	__attribute__((target("avx2,avx512f")))
+#define WB_TARGET_GFNI		__attribute__((target("sse2,gfni")))
+#define WB_TARGET_SSSE3		__attribute__((target("ssse3")))
+#else
+#define WB_TARGET_AVX2
+#define WB_TARGET_AVX512
+#define WB_TARGET_GFNI
+#define WB_TARGET_SSSE3
+#endif
+
+namespace NWhiteBox
+{
+
+enum cpu_feature_t
+{
+	wb_cpu_avx2 = 1,			// AVX2 and YMM state enabled by OS
+	wb_cpu_avx512 = 2,			// AVX-512F and ZMM state enabled by OS
+	wb_cpu_gfni = 4,			// GF2P8AFFINEQB and friends on XMM registers
+	wb_cpu_ssse3 = 8			// PSHUFB
+};
+
+uint32_t cpu_features();
+
+// Every kernel encrypts (D == wb_encryption) or decrypts count blocks with all rounds of t
+// (blocks_*), or applies one round t to count blocks (round_blocks_*). in may be equal to out.
+typedef void (*round_blocks_t)(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count);
+
+inline void xor_bytes(uint8_t const* in, uint8_t const* ks, uint8_t* out, size_t len)
+{
+	for (; len >= 8; len -= 8, in += 8, ks += 8, out += 8)
+	{
+		uint64_t a, b;
+		memcpy(&a, in, 8);
+		memcpy(&b, ks, 8);
+		a ^= b;
+		memcpy(out, &a, 8);
+	}
+	for (size_t i = 0; i < len; ++i)
+		out[i] = in[i] ^ ks[i];
+}
+
+// The final round of byte substitutions (see CTableSet::FinalSbox). in may be equal to out.
+template <direction_t D>
+inline void final_round(sbox_ptr_t s, uint8_t const* in, uint8_t* out)
+{
+	uint8_t b[16];
+	for (int j = 0; j < 16; ++j)
+		b[j] = s[j][in[round_input_order[D][j]]];
+	memcpy(out, b, sizeof(b));
+}
+
+template <direction_t D>
+void round_blocks_final(sbox_ptr_t s, uint8_t const* in, uint8_t* out, size_t count);
+
+template <direction_t D>
+void blocks_scalar(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count);
+template <direction_t D>
+void round_blocks_scalar(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count);
+
+// Scalar code with N = 2, 4 or 8 blocks interleaved
+template <direction_t D, int N>
+void blocks_interleaved(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count);
+template <direction_t D, int N>
+void round_blocks_interleaved(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count);
+
+#ifdef WB_SSE2
+template <direction_t D>
+void blocks_sse2(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count);
+template <direction_t D>
+void round_blocks_sse2(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count);
+#endif // WB_SSE2
+
+#ifdef WB_AVX2
+template <direction_t D>
+WB_TARGET_AVX2
+void blocks_avx2(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count);
+template <direction_t D>
+WB_TARGET_AVX2
+void round_blocks_avx2(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count);
+#endif // WB_AVX2
+
+#ifdef WB_AVX512
+template <direction_t D>
+WB_TARGET_AVX512
+void blocks_avx512(CTableSet const& t, uint8_t const* in, uint8_t* out, size_t count);
+template <direction_t D>
+WB_TARGET_AVX512
+void round_blocks_avx512(round_ptr_t t, uint8_t const* in, uint8_t* out, size_t count);
+#endif // WB_AVX512
+
+}
+
+#endif // KERNELS_H
@@ -0,0 +1,269 @@
+//***************************************************************************************
+// keyformat.cpp
+// Expansion of compact EVHEN white-box keys to lookup tables
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+#include "keyformat.h"
+#include "pool.h"
+#include "plcm.h"
+#include <string.h>
+#include <vector>
+#include <stdexcept>
+
+namespace NWhiteBox
+{
+
+namespace
+{
+
+// tbl[x] = M * x ^ c
+void affine_table(uint8_t const cols[8], uint8_t c, uint8_t tbl[256])
+{
+	tbl[0] = c;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		for (uint32_t x = 0; x < (1u << i); ++x)
+			tbl[x | (1u << i)] = tbl[x] ^ cols[i];
+	}
+}
+
+uint8_t apply_linear(uint8_t const cols[8], uint8_t x)
+{
+	uint8_t r(0);
+	for (uint32_t i = 0; i < 8; ++i, x >>= 1)
+	{
+		if (x & 1)
+			r ^= cols[i];
+	}
+	return r;
+}
+
+// The columns of a linear map are a basis of GF(2)^8
+bool is_invertible(uint8_t const cols[8])
+{
+	uint8_t basis[8] = { 0 };		// basis[b] has the upper bit b
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		uint8_t c = cols[i];
+		while (c)
+		{
+			uint32_t b(7);
+			while (!(c & (1u << b)))
+				--b;
+			if (!basis[b])
+			{
+				basis[b] = c;
+				break;
+			}
+			c ^= basis[b];
+		}
+		if (!c)
+			return false;
+	}
+	return true;
+}
+
+// x^8 + poly(x) has no divisors of degree 1 to 4
+bool is_irreducible(uint8_t poly)
+{
+	for (uint32_t g = 2; g < 32; ++g)
+	{
+		uint32_t dg(4);
+		while (!(g & (1u << dg)))
+			--dg;
+
+		uint32_t r = 0x100 | poly;
+		for (uint32_t i = 8; i >= dg; --i)
+		{
+			if (r & (1u << i))
+				r ^= g << (i - dg);
+		}
+		if (!r)
+			return false;
+	}
+	return true;
+}
+
+// A start point of the chaotic map in (0, 1), the others never give an s-box
+bool is_chaos_point(uint64_t const chaos[4])
+{
+	return !(chaos[3] >> 63) && (chaos[0] | chaos[1] | chaos[2] | chaos[3]);
+}
+
+bool is_permutation(uint8_t const s[256])
+{
+	bool seen[256] = { false };
+	for (uint32_t x = 0; x < 256; ++x)
+	{
+		if (seen[s[x]])
+			return false;
+		seen[s[x]] = true;
+	}
+	return true;
+}
+
+}
+
+void expand_round(key_round_t const& r, uint8_t const* const sboxes[16], round_tbl_t& tbl)
+{
+	for (uint32_t j = 0; j < 16; ++j)
+	{
+		// A T-box is affine too: cols[i] is the entry of 1 << i without the masks,
+		// byte cnt of it is mixes_cnt(mds[cnt][j] * x^i)
+		tbox_t cols[8];
+		for (uint32_t cnt = 0; cnt < 16; ++cnt)
+		{
+			uint8_t m = r.mds[cnt][j];
+			for (uint32_t i = 0; i < 8; ++i)
+			{
+				cols[i][cnt] = apply_linear(r.mixes[cnt], m);
+				m = (uint8_t)((m << 1) ^ ((m & 0x80) ? r.poly : 0));
+			}
+		}
+
+		tbox_t f[256];
+		memcpy(f[0], r.masks[j], sizeof(tbox_t));
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			for (uint32_t x = 0; x < (1u << i); ++x)
+			{
+				for (uint32_t cnt = 0; cnt < 16; ++cnt)
+					f[x | (1u << i)][cnt] = f[x][cnt] ^ cols[i][cnt];
+			}
+		}
+
+		uint8_t const* s = sboxes[j];
+		for (uint32_t x = 0; x < 256; ++x)
+			memcpy(tbl[j][x], f[s[x]], sizeof(tbox_t));
+	}
+}
+
+void expand_sbox(key_round_t const& r, direction_t dir, uint32_t j, round_sbox_t& sboxes, uint8_t const* clear)
+{
+	uint8_t created[256];
+	if (!clear)
+	{
+		NPrng::fixed_t x;
+		memcpy(x.w, r.chaos[j], sizeof(x.w));
+		NPrng::plcm_create_sbox(x, created);
+		clear = created;
+	}
+
+	uint8_t s[256];
+	uint32_t pos(j);
+	if (dir == wb_decryption)
+	{
+		pos = (j + (j % 4) * 4) % 16;
+		for (uint32_t i = 0; i < 256; ++i)
+			s[clear[i]] = (uint8_t)i;
+	}
+	else
+	{
+		memcpy(s, clear, sizeof(s));
+	}
+
+	uint8_t f[256];
+	affine_table(r.input[pos], r.input[pos][8], f);
+	for (uint32_t i = 0; i < 256; ++i)
+		sboxes[pos][f[i]] = s[i];
+}
+
+uint32_t check_key(void const* image, size_t size, bool verify)
+{
+	uint8_t const* base = (uint8_t const*)image;
+	key_file_header_t const* h = (key_file_header_t const*)image;
+
+	if (!image || size < sizeof(key_file_header_t) || memcmp(h->magic, key_file_magic, sizeof(key_file_magic)))
+		throw std::runtime_error("ERROR: Not an EVHEN key file!!!\n");
+	if (h->version != key_file_version || h->header_size != sizeof(key_file_header_t) || (h->flags & ~key_flag_sboxes) ||
+		h->round_size != key_round_size(h->flags))
+		throw std::runtime_error("ERROR: Unsupported version of key file!!!\n");
+	if (h->direction > wb_decryption || h->rounds_num < 2 || h->file_size != size ||
+		(uint64_t)h->rounds_num * h->round_size != size - h->header_size)
+		throw std::runtime_error("ERROR: Key file is corrupted!!!\n");
+	if (verify && tbl_checksum(base + h->header_size, size - h->header_size) != h->checksum)
+		throw std::runtime_error("ERROR: Checksum of key file mismatch!!!\n");
+
+	// Only the last round has no mixes and masks. The checksum doesn't protect from a crafted key,
+	// so everything the expansion relies on is checked here.
+	for (uint32_t i = 0; i < h->rounds_num; ++i)
+	{
+		key_round_t const& r = *(key_round_t const*)(base + h->header_size + (size_t)i * h->round_size);
+		round_sbox_t const* clear = (h->flags & key_flag_sboxes) ? (round_sbox_t const*)(&r + 1) : 0;
+		if (r.last != (i == h->rounds_num - 1) || !is_irreducible(r.poly))
+			throw std::runtime_error("ERROR: Key file is corrupted!!!\n");
+
+		for (uint32_t j = 0; j < 16; ++j)
+		{
+			if (!is_chaos_point(r.chaos[j]) || !is_invertible(r.input[j]) || (!r.last && !is_invertible(r.mixes[j])) ||
+				(clear && !is_permutation((*clear)[j])))
+				throw std::runtime_error("ERROR: Key file is corrupted!!!\n");
+		}
+	}
+
+	return h->rounds_num;
+}
+
+void expand_key(void const* image, round_tbl_t* rounds, round_sbox_t& final, CThreadPool* pool)
+{
+	key_file_header_t const* h = (key_file_header_t const*)image;
+	uint8_t const* base = (uint8_t const*)image + h->header_size;
+	direction_t dir = (direction_t)h->direction;
+	uint32_t rnum = h->rounds_num;
+	auto r = [&](size_t k) -> key_round_t const&
+	{
+		return *(key_round_t const*)(base + k * h->round_size);
+	};
+
+	// Without the clear s-boxes in the key they take almost all the time: every one is an orbit
+	// of the chaotic map, and all of them are independent. The last round is its s-boxes.
+	std::vector<uint8_t> storage((rnum - 1) * sizeof(round_sbox_t));
+	round_sbox_t* sboxes = (round_sbox_t*)&storage[0];
+
+	auto sbox = [&](size_t i)
+	{
+		uint32_t k = (uint32_t)(i / 16), j = (uint32_t)(i % 16);
+		uint8_t const* clear = (h->flags & key_flag_sboxes) ? (*(round_sbox_t const*)(&r(k) + 1))[j] : 0;
+		expand_sbox(r(k), dir, j, (k == rnum - 1) ? final : sboxes[k], clear);
+	};
+	auto tables = [&](size_t k)
+	{
+		uint8_t const* s[16];
+		for (uint32_t j = 0; j < 16; ++j)
+			s[j] = sboxes[k][j];
+		expand_round(r(k), s, rounds[k]);
+	};
+
+	if (pool)
+	{
+		pool->Run(rnum * 16, sbox);
+		pool->Run(rnum - 1, tables);
+	}
+	else
+	{
+		for (size_t i = 0; i < rnum * 16; ++i)
+			sbox(i);
+		for (size_t k = 0; k < rnum - 1; ++k)
+			tables(k);
+	}
+}
+
+}
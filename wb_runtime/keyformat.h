@@ -0,0 +1,110 @@
+//***************************************************************************************
+// keyformat.h
+// Compact EVHEN white-box keys (*_key.bin files of wb_creator)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+//
+// A key holds what a round is made of instead of its tables:
+//
+//   key_file_header_t                       64 bytes
+//   rounds_num rounds of round_size bytes:
+//     key_round_t                           1304 bytes
+//     round_sbox_t                          4096 bytes, the clear s-boxes (key_flag_sboxes only)
+//
+// The clear s-boxes are given by the start points of the chaotic map which created them
+// (see plcm.h), everything else is a few affine maps over GF(2). The orbits of the map take
+// almost all the time of expand_key(), so a key may keep the clear s-boxes too: a key of
+// 10 rounds takes 53 KB and expands in about 2 ms, 13 KB and 23 to 30 ms without them
+// (one core). Its tables take 580 KB, and expand_key() rebuilds them bit for bit.
+// The checksum covers everything after the header.
+//
+//***************************************************************************************
+
+#ifndef KEYFORMAT_H
+#define KEYFORMAT_H
+
+#include "tables.h"
+#include "tblformat.h"
+
+namespace NWhiteBox
+{
+
+class CThreadPool;
+
+static const char		key_file_magic[8] = { 'E', 'V', 'H', 'E', 'N', 'K', 'E', 'Y' };
+const uint32_t			key_file_version = 1;
+
+const uint32_t			key_flag_sboxes = 1;		// every round is followed by its clear s-boxes
+
+#pragma pack(push, 1)
+
+struct key_file_header_t
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;		// sizeof( key_file_header_t )
+	uint32_t	direction;			// direction_t
+	uint32_t	rounds_num;
+	uint32_t	round_size;			// key_round_size( flags )
+	uint32_t	flags;				// key_flag_*
+	uint64_t	file_size;
+	uint64_t	checksum;			// tbl_checksum() of bytes [header_size, file_size)
+	uint8_t		reserved[16];
+};
+
+// An affine map f(x) = M * x ^ c over GF(2) is given by the columns M * (1 << i) and c
+struct key_round_t
+{
+	uint64_t	chaos[16][4];		// start points of the clear s-boxes (NPrng::fixed_t). A decryption
+									// round inverts s-box j of an encryption round into (j + (j % 4) * 4) % 16
+	uint8_t		input[16][9];		// encoding of the input bytes by the previous round: s-box j is s(input_j^-1(x))
+	uint8_t		mixes[16][8];		// linear mixes of the output bytes
+	uint8_t		mds[16][16];		// the MDS matrix of the round (its inverse for decryption)
+	uint8_t		masks[16][16];		// masks[j][cnt] of byte cnt of an entry of T-box j
+	uint8_t		poly;				// irreducible polynomial of mds
+	uint8_t		last;				// the round has no mixes and masks and mds is the identity
+	uint8_t		reserved[6];
+};
+
+#pragma pack(pop)
+
+inline uint32_t key_round_size(uint32_t flags)
+{
+	return sizeof(key_round_t) + ((flags & key_flag_sboxes) ? sizeof(round_sbox_t) : 0);
+}
+
+// T-box j of the round: tbl[j][x][cnt] = mixes_cnt(mds[cnt][j] * sboxes[j][x]) ^ masks[j][cnt]
+void expand_round(key_round_t const& r, uint8_t const* const sboxes[16], round_tbl_t& tbl);
+
+// Encoded s-box of the round which the start point chaos[j] gives. clear is the s-box
+// if the key keeps it, otherwise the chaotic map creates it.
+void expand_sbox(key_round_t const& r, direction_t dir, uint32_t j, round_sbox_t& sboxes, uint8_t const* clear = 0);
+
+// Checks a key image and returns the number of rounds
+uint32_t check_key(void const* image, size_t size, bool verify = true);
+
+// rounds gets rounds_num - 1 rounds of T-boxes and final gets the byte substitutions of the last one.
+// The s-boxes of all rounds are created at the same time by the threads of the pool.
+void expand_key(void const* image, round_tbl_t* rounds, round_sbox_t& final, CThreadPool* pool = 0);
+
+}
+
+#endif // KEYFORMAT_H
@@ -0,0 +1,134 @@
+//***************************************************************************************
+// mapfile.cpp
+// A read-only memory mapped file
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "mapfile.h"
+#include <string>
+#include <stdexcept>
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // WIN32
+
+namespace NWhiteBox
+{
+
+#ifdef WIN32
+
+CMappedFile::CMappedFile() : m_data(0), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(0)
+{
+}
+
+void CMappedFile::Open(char const* fname)
+{
+	Close();
+
+	m_file = ::CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error(std::string("ERROR: Can\'t open \'") + fname + "\' file!!!\n");
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(m_file, &size) || !size.QuadPart || (uint64_t)size.QuadPart > (size_t)-1)
+	{
+		Close();
+		throw std::runtime_error(std::string("ERROR: Illegal size of \'") + fname + "\' file!!!\n");
+	}
+
+	m_mapping = ::CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping)
+		m_data = ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data)
+	{
+		Close();
+		throw std::runtime_error(std::string("ERROR: Can\'t map \'") + fname + "\' file!!!\n");
+	}
+	m_size = (size_t)size.QuadPart;
+}
+
+void CMappedFile::Close()
+{
+	if (m_data)
+		::UnmapViewOfFile(m_data);
+	if (m_mapping)
+		::CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		::CloseHandle(m_file);
+	m_data = 0;
+	m_size = 0;
+	m_mapping = 0;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+CMappedFile::CMappedFile() : m_data(0), m_size(0)
+{
+}
+
+void CMappedFile::Open(char const* fname)
+{
+	Close();
+
+	int fd = ::open(fname, O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error(std::string("ERROR: Can\'t open \'") + fname + "\' file!!!\n");
+
+	struct stat st;
+	if (::fstat(fd, &st) || st.st_size <= 0)
+	{
+		::close(fd);
+		throw std::runtime_error(std::string("ERROR: Illegal size of \'") + fname + "\' file!!!\n");
+	}
+
+	// The mapping is shared, so all processes which load the same tables use one page cache copy
+	void* p = ::mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+		throw std::runtime_error(std::string("ERROR: Can\'t map \'") + fname + "\' file!!!\n");
+
+	m_data = p;
+	m_size = (size_t)st.st_size;
+}
+
+void CMappedFile::Close()
+{
+	if (m_data)
+		::munmap((void*)m_data, m_size);
+	m_data = 0;
+	m_size = 0;
+}
+
+#endif // WIN32
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+}
@@ -0,0 +1,75 @@
+//***************************************************************************************
+// mapfile.h
+// A read-only memory mapped file
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include "stdtypes.h"
+#include <stddef.h>
+
+namespace NWhiteBox
+{
+
+class CMappedFile
+{
+public:
+	CMappedFile();
+	virtual ~CMappedFile();
+
+public:
+	void Open(char const* fname);
+	void Close();
+
+public:
+	bool IsOpen() const
+	{
+		return m_data != 0;
+	}
+
+	void const* Data() const
+	{
+		return m_data;
+	}
+
+	size_t Size() const
+	{
+		return m_size;
+	}
+
+private:
+	CMappedFile(CMappedFile const&);
+	CMappedFile const& operator =(CMappedFile const&);
+
+private:
+	void const*	m_data;
+	size_t		m_size;
+#ifdef WIN32
+	void*		m_file;
+	void*		m_mapping;
+#endif // WIN32
+};
+
+}
+
+#endif // MAPFILE_H
@@ -0,0 +1,577 @@
+//***************************************************************************************
+// plcm.cpp
+// Fixed-point piecewise linear chaotic map (PLCM)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "plcm.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <stdexcept>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif // _MSC_VER && _M_X64
+
+namespace NPrng
+{
+
+// Returns the lower half of a * b, hi gets the upper one
+static inline uint64_t mul_wide(uint64_t a, uint64_t b, uint64_t& hi)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return _umul128(a, b, &hi);
+#elif defined(__SIZEOF_INT128__)
+	unsigned __int128 p = (unsigned __int128)a * b;
+	hi = (uint64_t)(p >> 64);
+	return (uint64_t)p;
+#else
+	uint64_t al = (uint32_t)a, ah = a >> 32, bl = (uint32_t)b, bh = b >> 32;
+	uint64_t ll = al * bl, lh = al * bh, hl = ah * bl;
+	uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+	hi = ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+	return (mid << 32) | (uint32_t)ll;
+#endif
+}
+
+// r = a * b + c + carry, carry gets the upper half
+static inline uint64_t mul_add(uint64_t a, uint64_t b, uint64_t c, uint64_t& carry)
+{
+	uint64_t hi;
+	uint64_t lo = mul_wide(a, b, hi);
+	lo += c;
+	hi += lo < c;
+	lo += carry;
+	hi += lo < carry;
+	carry = hi;
+	return lo;
+}
+
+// q = floor((u1 * 2^64 + u0) / d), r = the remainder. u1 < d, the upper bit of d is set and
+// v = floor((2^128 - 1) / d) - 2^64 (Moller, Granlund: Improved division by invariant integers).
+static inline uint64_t div_word(uint64_t u1, uint64_t u0, uint64_t d, uint64_t v, uint64_t& r)
+{
+	uint64_t q1;
+	uint64_t q0 = mul_wide(v, u1, q1);
+	q0 += u0;
+	q1 += u1 + (q0 < u0);
+	++q1;
+	r = u0 - q1 * d;
+
+	// The first correction is taken half of the time, so it is done without a branch
+	uint64_t mask = 0 - (uint64_t)(r > q0);
+	q1 += mask;
+	r += d & mask;
+	if (r >= d)
+	{
+		++q1;
+		r -= d;
+	}
+	return q1;
+}
+
+static int cmp_limbs(uint64_t const* a, uint64_t const* b, uint32_t n)
+{
+	for (uint32_t i = n; i-- > 0;)
+	{
+		if (a[i] != b[i])
+			return (a[i] < b[i]) ? -1 : 1;
+	}
+	return 0;
+}
+
+// r = a - b modulo 2^(64 * n)
+static void sub_limbs(uint64_t* r, uint64_t const* a, uint64_t const* b, uint32_t n)
+{
+	uint64_t borrow(0);
+	for (uint32_t i = 0; i < n; ++i)
+	{
+		uint64_t t = a[i] - b[i];
+		uint64_t next = (a[i] < b[i]) | (t < borrow);
+		r[i] = t - borrow;
+		borrow = next;
+	}
+}
+
+// r = a + b modulo 2^(64 * n)
+static void add_limbs(uint64_t* r, uint64_t const* a, uint64_t const* b, uint32_t n)
+{
+	uint64_t carry(0);
+	for (uint32_t i = 0; i < n; ++i)
+	{
+		uint64_t t = a[i] + carry;
+		carry = t < carry;
+		r[i] = t + b[i];
+		carry += r[i] < t;
+	}
+}
+
+// The integer of a fixed-point number with a relative error of a few ulps
+static double to_double(fixed_t const& a)
+{
+	double r(0);
+	for (uint32_t i = fixed_limbs; i-- > 0;)
+		r = r * 18446744073709551616.0 + (double)a.w[i];
+	return r;
+}
+
+// q = floor(u / v), where u has m digits, v has n digits and v[n - 1] != 0.
+// q has m - n + 1 digits. Knuth's algorithm D with 32-bit digits.
+static void divide(uint32_t* q, uint32_t const* u, uint32_t m, uint32_t const* v, uint32_t n)
+{
+	const uint32_t max_digits = 4 * fixed_limbs;
+	uint32_t un[max_digits + 1];
+	uint32_t vn[max_digits];
+
+	if (n == 1)
+	{
+		uint64_t r(0);
+		for (uint32_t i = m; i-- > 0;)
+		{
+			uint64_t cur = (r << 32) | u[i];
+			q[i] = (uint32_t)(cur / v[0]);
+			r = cur % v[0];
+		}
+		return;
+	}
+
+	// Normalize, so the most significant bit of the divisor is set
+	uint32_t s(0);
+	for (uint32_t t = v[n - 1]; !(t & 0x80000000); t <<= 1)
+		++s;
+
+	for (uint32_t i = n - 1; i > 0; --i)
+		vn[i] = s ? (v[i] << s) | (v[i - 1] >> (32 - s)) : v[i];
+	vn[0] = v[0] << s;
+
+	un[m] = s ? u[m - 1] >> (32 - s) : 0;
+	for (uint32_t i = m - 1; i > 0; --i)
+		un[i] = s ? (u[i] << s) | (u[i - 1] >> (32 - s)) : u[i];
+	un[0] = u[0] << s;
+
+	for (uint32_t j = m - n + 1; j-- > 0;)
+	{
+		uint64_t num = ((uint64_t)un[j + n] << 32) | un[j + n - 1];
+		uint64_t qhat = num / vn[n - 1];
+		uint64_t rhat = num % vn[n - 1];
+
+		while (qhat >> 32 || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+		{
+			--qhat;
+			rhat += vn[n - 1];
+			if (rhat >> 32)
+				break;
+		}
+
+		// un[j .. j + n] -= qhat * vn
+		uint64_t borrow(0);
+		for (uint32_t i = 0; i < n; ++i)
+		{
+			uint64_t p = qhat * vn[i] + borrow;
+			borrow = p >> 32;
+			if (un[i + j] < (uint32_t)p)
+				++borrow;
+			un[i + j] -= (uint32_t)p;
+		}
+		bool negative = un[j + n] < borrow;
+		un[j + n] -= (uint32_t)borrow;
+
+		// qhat was one too large, add the divisor back
+		if (negative)
+		{
+			--qhat;
+			uint64_t carry(0);
+			for (uint32_t i = 0; i < n; ++i)
+			{
+				uint64_t t = (uint64_t)un[i + j] + vn[i] + carry;
+				un[i + j] = (uint32_t)t;
+				carry = t >> 32;
+			}
+			un[j + n] += (uint32_t)carry;
+		}
+		q[j] = (uint32_t)qhat;
+	}
+}
+
+void fixed_set_double(fixed_t& r, double d)
+{
+	if (!(d >= 0 && d < 2))
+		throw std::runtime_error("ERROR: A fixed-point number is out of range!!!\n");
+
+	memset(r.w, 0, sizeof(r.w));
+
+	// d = mant * 2^(e - 53), where mant has 53 bits
+	int e;
+	uint64_t mant = (uint64_t)ldexp(frexp(d, &e), 53);
+	int pos = e - 53 + (int)fixed_frac_bits;
+	if (pos < 0)
+	{
+		if (pos <= -64)
+			return;
+		mant >>= -pos;
+		pos = 0;
+	}
+
+	uint32_t limb = (uint32_t)pos / 64, shift = (uint32_t)pos % 64;
+	r.w[limb] |= mant << shift;
+	if (shift && limb + 1 < fixed_limbs)
+		r.w[limb + 1] |= mant >> (64 - shift);
+}
+
+void fixed_set_decimal(fixed_t& r, char const* digits)
+{
+	// floor(N * 2^255 / 10^len), where N is the integer of the digits.
+	// The nested floors of divisions by 10 give the same result.
+	std::vector<uint32_t> n(1, 0);
+	uint32_t len(0);
+	for (; digits[len]; ++len)
+	{
+		if (digits[len] < '0' || digits[len] > '9')
+			throw std::runtime_error("ERROR: Illegal decimal number!!!\n");
+
+		uint64_t carry = (uint32_t)(digits[len] - '0');
+		for (size_t i = 0; i < n.size(); ++i)
+		{
+			uint64_t t = (uint64_t)n[i] * 10 + carry;
+			n[i] = (uint32_t)t;
+			carry = t >> 32;
+		}
+		if (carry)
+			n.push_back((uint32_t)carry);
+	}
+
+	// Multiply by 2^255
+	const uint32_t lo = fixed_frac_bits / 32, shift = fixed_frac_bits % 32;
+	std::vector<uint32_t> big(lo + n.size() + 1, 0);
+	for (size_t i = 0; i < n.size(); ++i)
+	{
+		big[lo + i] |= n[i] << shift;
+		big[lo + i + 1] |= n[i] >> (32 - shift);
+	}
+
+	for (uint32_t k = 0; k < len; ++k)
+	{
+		uint64_t rem(0);
+		for (size_t i = big.size(); i-- > 0;)
+		{
+			uint64_t cur = (rem << 32) | big[i];
+			big[i] = (uint32_t)(cur / 10);
+			rem = cur % 10;
+		}
+	}
+
+	big.resize(2 * fixed_limbs + 1, 0);
+	for (uint32_t i = 0; i < fixed_limbs; ++i)
+		r.w[i] = ((uint64_t)big[2 * i + 1] << 32) | big[2 * i];
+}
+
+int fixed_cmp(fixed_t const& a, fixed_t const& b)
+{
+	return cmp_limbs(a.w, b.w, fixed_limbs);
+}
+
+void fixed_sub(fixed_t& r, fixed_t const& a, fixed_t const& b)
+{
+	sub_limbs(r.w, a.w, b.w, fixed_limbs);
+}
+
+void fixed_set_divisor(fixed_divisor_t& r, fixed_t const& d)
+{
+	if (!d.w[fixed_limbs - 1])
+		throw std::runtime_error("ERROR: A divisor is too small!!!\n");
+
+	// inv = floor(2^511 / d), d >= 2^192 as an integer, so inv < 2^320
+	const uint32_t digits = 2 * fixed_limbs;
+	uint32_t v[digits], u[2 * digits] = { 0 }, q[2 * digits] = { 0 };
+	for (uint32_t i = 0; i < fixed_limbs; ++i)
+	{
+		v[2 * i] = (uint32_t)d.w[i];
+		v[2 * i + 1] = (uint32_t)(d.w[i] >> 32);
+	}
+	uint32_t n = v[digits - 1] ? digits : digits - 1;
+	u[2 * digits - 1] = 0x80000000;
+	divide(q, u, 2 * digits, v, n);
+
+	for (uint32_t i = 0; i < fixed_limbs + 1; ++i)
+		r.inv[i] = ((uint64_t)q[2 * i + 1] << 32) | q[2 * i];
+	r.d = d;
+
+	// The bits [low, top] of d are its word: d = word * 2^(top - 63) as an integer, so
+	// a quotient is floor(a * 2^(255 + 63 - top) / word), and a * 2^shift must fit 6 limbs
+	r.word = 0;
+	r.word_inv = 0;
+	r.shift = 0;
+	uint32_t top = fixed_limbs * 64 - 1;
+	while (!((d.w[top / 64] >> (top % 64)) & 1))
+		--top;
+	if (fixed_frac_bits + 63 - top >= 128)
+		return;
+
+	uint32_t low = top - 63;
+	for (uint32_t i = 0; i < low; ++i)
+	{
+		if ((d.w[i / 64] >> (i % 64)) & 1)
+			return;
+	}
+
+	uint64_t word = d.w[low / 64] >> (low % 64);
+	if (low % 64)
+		word |= d.w[low / 64 + 1] << (64 - low % 64);
+
+	// floor((2^128 - 1) / word) - 2^64 = floor(((2^64 - 1 - word) * 2^64 + 2^64 - 1) / word)
+	uint32_t wu[4] = { 0xffffffff, 0xffffffff, (uint32_t)~word, (uint32_t)(~word >> 32) };
+	uint32_t wv[2] = { (uint32_t)word, (uint32_t)(word >> 32) };
+	uint32_t wq[3];
+	divide(wq, wu, 4, wv, 2);
+
+	r.word = word;
+	r.word_inv = ((uint64_t)wq[1] << 32) | wq[0];
+	r.shift = fixed_frac_bits + 63 - top;
+}
+
+void fixed_div(fixed_t& r, fixed_t const& a, fixed_divisor_t const& d)
+{
+	const uint32_t n = fixed_limbs + 1;
+
+	if (d.word)
+	{
+		// The exact quotient of a * 2^shift (6 limbs) by the word, from the upper limb down
+		uint64_t u[fixed_limbs + 2] = { 0 }, q[fixed_limbs + 2];
+		uint32_t limb = d.shift / 64, bits = d.shift % 64;
+		for (uint32_t i = 0; i < fixed_limbs; ++i)
+		{
+			u[i + limb] |= a.w[i] << bits;
+			if (bits)
+				u[i + limb + 1] |= a.w[i] >> (64 - bits);
+		}
+
+		uint64_t rem(0);
+		for (uint32_t i = fixed_limbs + 2; i-- > 0;)
+			q[i] = div_word(rem, u[i], d.word, d.word_inv, rem);
+
+		if (q[fixed_limbs] || q[fixed_limbs + 1])
+			throw std::runtime_error("ERROR: A fixed-point number is out of range!!!\n");
+		memcpy(r.w, q, sizeof(r.w));
+		return;
+	}
+
+	// a * 2^255 < 2^511, so q = floor(a * inv / 2^256) is the quotient or at most 2 less
+	uint64_t prod[fixed_limbs + n];
+	for (uint32_t j = 0; j < n; ++j)
+		prod[j] = 0;
+	for (uint32_t i = 0; i < fixed_limbs; ++i)
+	{
+		uint64_t carry(0);
+		for (uint32_t j = 0; j < n; ++j)
+			prod[i + j] = mul_add(a.w[i], d.inv[j], prod[i + j], carry);
+		prod[i + n] = carry;
+	}
+	uint64_t* q = prod + fixed_limbs;
+
+	// rem = a * 2^255 - q * d < 3 * d, so the lower 320 bits are enough
+	uint64_t rem[n] = { 0 };
+	rem[fixed_limbs - 1] = a.w[0] << 63;
+	rem[fixed_limbs] = (a.w[0] >> 1) | (a.w[1] << 63);
+
+	uint64_t qd[n] = { 0 };
+	for (uint32_t i = 0; i < n; ++i)
+	{
+		uint64_t carry(0);
+		for (uint32_t j = 0; i + j < n && j < fixed_limbs; ++j)
+			qd[i + j] = mul_add(q[i], d.d.w[j], qd[i + j], carry);
+		if (i + fixed_limbs < n)
+			qd[i + fixed_limbs] = carry;
+	}
+	sub_limbs(rem, rem, qd, n);
+
+	uint64_t dd[n];
+	memcpy(dd, d.d.w, sizeof(d.d.w));
+	dd[fixed_limbs] = 0;
+	while (cmp_limbs(rem, dd, n) >= 0)
+	{
+		sub_limbs(rem, rem, dd, n);
+		for (uint32_t i = 0; i < n && !++q[i]; ++i)
+			;
+	}
+
+	if (q[fixed_limbs])
+		throw std::runtime_error("ERROR: A fixed-point number is out of range!!!\n");
+	memcpy(r.w, q, sizeof(r.w));
+}
+
+uint32_t fixed_div_int(fixed_t const& a, uint32_t shift, fixed_t const& b)
+{
+	const uint32_t n = fixed_limbs + 1;
+
+	if (shift >= 32 || !fixed_cmp(b, fixed_t()))
+		throw std::runtime_error("ERROR: Illegal arguments of fixed_div_int!!!\n");
+
+	// Both numbers have 255 fractional bits, so it's the quotient of the integers.
+	// The error of the estimate is far less than 1 since the quotient has at most 32 bits.
+	double est = to_double(a) * (double)((uint64_t)1 << shift) / to_double(b);
+	if (!(est < 4294967296.0))
+		throw std::runtime_error("ERROR: A fixed-point number is out of range!!!\n");
+	uint64_t q = (uint64_t)est;
+
+	// The estimate is not close to an integer, so it is truncated exactly
+	double err = est * 1e-12 + 1e-12;
+	if ((uint64_t)(est - err) == q && (uint64_t)(est + err) == q && est - err >= 0)
+		return (uint32_t)q;
+
+	// rem = a * 2^shift - q * b, the upper bit is the sign
+	uint64_t rem[n], qb[n], bb[n];
+	for (uint32_t i = 0; i < fixed_limbs; ++i)
+	{
+		rem[i] = a.w[i] << shift;
+		if (i && shift)
+			rem[i] |= a.w[i - 1] >> (64 - shift);
+		bb[i] = b.w[i];
+	}
+	rem[fixed_limbs] = shift ? a.w[fixed_limbs - 1] >> (64 - shift) : 0;
+	bb[fixed_limbs] = 0;
+
+	uint64_t carry(0);
+	for (uint32_t i = 0; i < fixed_limbs; ++i)
+		qb[i] = mul_add(b.w[i], q, 0, carry);
+	qb[fixed_limbs] = carry;
+	sub_limbs(rem, rem, qb, n);
+
+	for (; rem[fixed_limbs] >> 63; --q)
+		add_limbs(rem, rem, bb, n);
+	for (; cmp_limbs(rem, bb, n) >= 0; ++q)
+		sub_limbs(rem, rem, bb, n);
+
+	return (uint32_t)q;
+}
+
+// 64 bits of a from the bit pos
+static inline uint64_t bits_at(fixed_t const& a, uint32_t pos)
+{
+	uint32_t limb = pos / 64, bits = pos % 64;
+	if (limb >= fixed_limbs)
+		return 0;
+	uint64_t r = a.w[limb] >> bits;
+	if (bits && limb + 1 < fixed_limbs)
+		r |= a.w[limb + 1] << (64 - bits);
+	return r;
+}
+
+uint32_t fixed_div_int(fixed_t const& a, uint32_t shift, fixed_divisor_t const& b)
+{
+	// floor(a * 2^shift / d) = floor(floor(a / 2^e) / word) with d = word * 2^(255 - b.shift)
+	// as an integer. floor(a / 2^e) of 128 bits takes two divisions of words.
+	uint32_t e = fixed_frac_bits - b.shift - shift;
+	if (!b.word || shift >= 32 || b.shift + shift >= fixed_frac_bits || e < 128)
+		return fixed_div_int(a, shift, b.d);
+
+	uint64_t rem(0);
+	uint64_t hi = div_word(0, bits_at(a, e + 64), b.word, b.word_inv, rem);
+	uint64_t q = div_word(rem, bits_at(a, e), b.word, b.word_inv, rem);
+	if (hi || q >> 32)
+		throw std::runtime_error("ERROR: A fixed-point number is out of range!!!\n");
+	return (uint32_t)q;
+}
+
+void plcm_set_param(plcm_param_t& r, double p)
+{
+	if (!(p > 0 && p < 0.5))
+		throw std::runtime_error("ERROR: Illegal control parameter of PLCM!!!\n");
+
+	fixed_set_double(r.half, 0.5);
+	fixed_set_double(r.one, 1);
+
+	fixed_t t;
+	fixed_set_double(t, p);
+	fixed_set_divisor(r.p, t);
+	fixed_sub(t, r.half, t);
+	fixed_set_divisor(r.half_p, t);
+}
+
+void iterate_PLCM(fixed_t& res, fixed_t const& x, plcm_param_t const& p)
+{
+	if (fixed_cmp(x, p.p.d) <= 0) // 0 <= x <= p
+	{
+		fixed_div(res, x, p.p);
+	}
+	else if (fixed_cmp(x, p.half) <= 0) // p < x <= 0.5
+	{
+		fixed_t s1;
+		fixed_sub(s1, x, p.p.d);
+		fixed_div(res, s1, p.half_p);
+	}
+	else if (fixed_cmp(x, p.one) <= 0) // 0.5 < x <= 1
+	{
+		fixed_t s1;
+		fixed_sub(s1, p.one, x);
+		iterate_PLCM(res, s1, p);
+	}
+}
+
+void plcm_create_sbox(fixed_t& x, uint8_t sbox[256])
+{
+	fixed_t left, right, width, s1;
+	fixed_divisor_t div_width;
+	plcm_param_t p;
+	plcm_set_param(p, 0.15);
+
+	fixed_set_double(left, 0.1);
+	fixed_set_double(right, 0.9);
+	fixed_sub(width, right, left);
+	fixed_set_divisor(div_width, width);
+
+	// An orbit takes about 1900 points and less than 6000 for random start points. A point
+	// out of (0, 1) or an orbit which falls into a cycle would never give all the indices.
+	const uint32_t max_iterations = 1 << 16;
+
+	uint32_t cnt(0);
+	bool is_init[256] = { false };
+
+	for (uint32_t i = 0; cnt < 256; ++i)
+	{
+		if (i == max_iterations)
+			throw std::runtime_error("ERROR: Chaotic map doesn't create an s-box from the start point!!!\n");
+
+		iterate_PLCM(x, x, p);
+
+		// index = (x - left) / ((right - left) / 256) truncated toward zero.
+		// Points out of [left, right] wrap around like a cast of a negative or a big number to uint8_t.
+		uint8_t index;
+		if (fixed_cmp(x, left) >= 0)
+		{
+			fixed_sub(s1, x, left);
+			index = (uint8_t)fixed_div_int(s1, 8, div_width);
+		}
+		else
+		{
+			fixed_sub(s1, left, x);
+			index = (uint8_t)(0 - fixed_div_int(s1, 8, div_width));
+		}
+
+		if (is_init[index])
+			continue;
+
+		is_init[index] = true;
+		sbox[cnt++] = index;
+	}
+}
+
+}
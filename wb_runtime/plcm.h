@@ -0,0 +1,105 @@
+//***************************************************************************************
+// plcm.h
+// Fixed-point piecewise linear chaotic map (PLCM)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+//
+// A state of the map is an unsigned fixed-point number with 1 integer and 255 fractional
+// bits, so [0, 2) with the step 2^-255. Every operation is exact except of a division
+// which truncates the quotient to 255 fractional bits. The result doesn't depend on
+// a compiler or a platform, and a state lives on the stack (no heap, no library).
+//
+//***************************************************************************************
+
+#ifndef PLCM_H
+#define PLCM_H
+
+#include "stdtypes.h"
+
+namespace NPrng
+{
+
+const uint32_t fixed_limbs = 4;			// 64-bit limbs, the least significant one first
+const uint32_t fixed_frac_bits = 255;
+
+struct fixed_t
+{
+	uint64_t	w[fixed_limbs];
+};
+
+// r = d, 0 <= d < 2. Any such double is represented exactly.
+void fixed_set_double(fixed_t& r, double d);
+
+// r = 0.digits truncated to 255 bits, e.g. "31415" gives 0.31415
+void fixed_set_decimal(fixed_t& r, char const* digits);
+
+int fixed_cmp(fixed_t const& a, fixed_t const& b);
+
+// r = a - b, a >= b
+void fixed_sub(fixed_t& r, fixed_t const& a, fixed_t const& b);
+
+// A divisor with its reciprocal, so a division takes two multiplications.
+// A divisor of at most 64 significant bits (e.g. set from a double) is a word: a / d is
+// floor(a * 2^shift / word) of integers, which takes a division of a word per limb.
+struct fixed_divisor_t
+{
+	fixed_t		d;
+	uint64_t	inv[fixed_limbs + 1];		// floor(2^511 / d)
+	uint64_t	word;						// the significant bits with the upper one set, or 0
+	uint64_t	word_inv;					// floor((2^128 - 1) / word) - 2^64
+	uint32_t	shift;
+};
+
+// d >= 2^-63
+void fixed_set_divisor(fixed_divisor_t& r, fixed_t const& d);
+
+// r = a / d truncated to 255 fractional bits, a / d < 2
+void fixed_div(fixed_t& r, fixed_t const& a, fixed_divisor_t const& d);
+
+// floor(a * 2^shift / b), shift < 32 and the quotient must fit into 32 bits
+uint32_t fixed_div_int(fixed_t const& a, uint32_t shift, fixed_t const& b);
+uint32_t fixed_div_int(fixed_t const& a, uint32_t shift, fixed_divisor_t const& b);
+
+struct plcm_param_t
+{
+	fixed_divisor_t		p;
+	fixed_divisor_t		half_p;		// 0.5 - p
+	fixed_t				half;
+	fixed_t				one;
+};
+
+// 0 < p < 0.5
+void plcm_set_param(plcm_param_t& r, double p);
+
+// res = PLCM(x):
+//   x / p                   0 <= x <= p
+//   (x - p) / (0.5 - p)     p < x <= 0.5
+//   PLCM(1 - x)             0.5 < x <= 1
+void iterate_PLCM(fixed_t& res, fixed_t const& x, plcm_param_t const& p);
+
+// A chaotic s-box (Asim, Jeoti): the orbit of x with p = 0.15, every point of [0.1, 0.9]
+// gives an index, and the new ones make the s-box. x becomes the last point of the orbit.
+// Throws if 2^16 points of the orbit don't give all the indices, e.g. for x out of (0, 1).
+void plcm_create_sbox(fixed_t& x, uint8_t sbox[256]);
+
+}
+
+#endif // PLCM_H
@@ -0,0 +1,164 @@
+//***************************************************************************************
+// pool.cpp
+// A pool of worker threads running parallel loops
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "pool.h"
+
+namespace NWhiteBox
+{
+
+// The pool whose task the calling thread runs now
+static thread_local CThreadPool const* current_pool = 0;
+
+class CPoolScope
+{
+public:
+	explicit CPoolScope(CThreadPool const* pool) : m_prev(current_pool)
+	{
+		current_pool = pool;
+	}
+
+	~CPoolScope()
+	{
+		current_pool = m_prev;
+	}
+
+private:
+	CThreadPool const*	m_prev;
+};
+
+CThreadPool::CThreadPool(uint32_t threads) : m_task(0), m_count(0), m_next(0), m_busy(0),
+	m_generation(0), m_stop(false)
+{
+	if (!threads)
+		threads = std::thread::hardware_concurrency();
+
+	for (uint32_t i = 1; i < threads; ++i)
+		m_threads.push_back(std::thread(&CThreadPool::Worker, this));
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_threads.size(); ++i)
+		m_threads[i].join();
+}
+
+void CThreadPool::Run(size_t count, task_t const& task)
+{
+	if (!count)
+		return;
+
+	// A task of this pool which calls Run again does the tasks itself: the other threads are
+	// busy with the outer Run, and m_run_lock is held by it.
+	if (current_pool == this)
+	{
+		for (size_t i = 0; i < count; ++i)
+			task(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> run_lock(m_run_lock);
+
+	if (m_threads.empty() || count == 1)
+	{
+		CPoolScope scope(this);
+		for (size_t i = 0; i < count; ++i)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_task = &task;
+		m_count = count;
+		m_next = 0;
+		m_error = std::exception_ptr();
+		m_busy = m_threads.size();
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	Execute();
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		while (m_busy)
+			m_done.wait(lock);
+		m_task = 0;
+		error = m_error;
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void CThreadPool::Worker()
+{
+	uint64_t generation(0);
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			while (!m_stop && m_generation == generation)
+				m_wake.wait(lock);
+			if (m_stop)
+				return;
+			generation = m_generation;
+		}
+
+		Execute();
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (!--m_busy)
+			m_done.notify_one();
+	}
+}
+
+void CThreadPool::Execute()
+{
+	CPoolScope scope(this);
+	for (size_t i = m_next++; i < m_count; i = m_next++)
+	{
+		try
+		{
+			(*m_task)(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (!m_error)
+				m_error = std::current_exception();
+			m_next = m_count;		// skip the rest
+		}
+	}
+}
+
+}
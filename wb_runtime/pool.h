@@ -0,0 +1,89 @@
+//***************************************************************************************
+// pool.h
+// A pool of worker threads running parallel loops
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "stdtypes.h"
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <functional>
+
+namespace NWhiteBox
+{
+
+class CThreadPool
+{
+public:
+	typedef std::function<void (size_t)> task_t;
+
+public:
+	// threads is the number of threads taking part in Run() including the calling one,
+	// 0 means one per CPU core
+	explicit CThreadPool(uint32_t threads = 0);
+	virtual ~CThreadPool();
+
+public:
+	// Calls task(i) for every i in [0, count) and waits for all of them. Tasks are taken by
+	// free threads one by one. The first exception thrown by a task is rethrown here.
+	// A task may call Run of the same pool: the inner tasks run one after another on the thread
+	// of that task (e.g. a batch of keys on the pool with the rounds of every key on the same pool).
+	// Calls of Run from other threads wait for the current one.
+	void Run(size_t count, task_t const& task);
+
+	uint32_t ThreadsNum() const
+	{
+		return (uint32_t)m_threads.size() + 1;
+	}
+
+private:
+	CThreadPool(CThreadPool const&);
+	CThreadPool const& operator =(CThreadPool const&);
+
+	void Worker();
+	void Execute();
+
+private:
+	std::vector<std::thread>	m_threads;
+	std::mutex					m_run_lock;		// one Run() at a time
+	std::mutex					m_lock;
+	std::condition_variable		m_wake;
+	std::condition_variable		m_done;
+	task_t const*				m_task;
+	size_t						m_count;
+	std::atomic<size_t>			m_next;
+	size_t						m_busy;			// workers which have not finished the current run
+	uint64_t					m_generation;	// number of runs started
+	bool						m_stop;
+	std::exception_ptr			m_error;
+};
+
+}
+
+#endif // POOL_H
@@ -0,0 +1,8 @@
+#ifndef STDTYPES_H
+#define STDTYPES_H
+
+#include <stdint.h>
+
+typedef uint8_t             tbox_t[16];
+
+#endif // STDTYPES_H
\ No newline at end of file
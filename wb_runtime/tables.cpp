@@ -0,0 +1,212 @@
+//***************************************************************************************
+// tables.cpp
+// A set of EVHEN white-box lookup tables (public or private key) loaded at runtime
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#include "tables.h"
+#include "tblformat.h"
+#include "keyformat.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+
+#ifdef WIN32
+#include <malloc.h>
+#endif // WIN32
+
+namespace NWhiteBox
+{
+
+void* alloc_aligned(size_t size)
+{
+	void* p;
+#ifdef WIN32
+	p = _aligned_malloc(size, 64);
+#else
+	if (posix_memalign(&p, 64, size))
+		p = 0;
+#endif // WIN32
+	if (!p)
+		throw std::runtime_error("ERROR: Not enough memory for lookup tables!!!\n");
+	return p;
+}
+
+void free_aligned(void* p)
+{
+	if (!p)
+		return;
+#ifdef WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif // WIN32
+}
+
+//
+// CTableSet
+//
+
+CTableSet::CTableSet() : m_dir(wb_encryption), m_final(0), m_storage(0), m_final_storage(0)
+{
+}
+
+CTableSet::~CTableSet()
+{
+	Release();
+}
+
+// rounds holds rnum rounds of T-boxes. A sparse last one is compressed if final is not given.
+void CTableSet::SetRounds(direction_t dir, round_ptr_t const* rounds, uint32_t rnum, sbox_ptr_t final)
+{
+	if (!final && is_sparse_round(rounds[rnum - 1]))
+	{
+		m_final_storage = alloc_aligned(sizeof(round_sbox_t));
+		compress_round(rounds[rnum - 1], *(round_sbox_t*)m_final_storage);
+		final = *(round_sbox_t const*)m_final_storage;
+		--rnum;
+	}
+
+	m_dir = dir;
+	m_rounds.assign(rounds, rounds + rnum);
+	m_final = final;
+}
+
+void CTableSet::Attach(direction_t dir, round_ptr_t const* rounds, uint32_t rnum, sbox_ptr_t final)
+{
+	if (!rounds || rnum < 2)
+		throw std::runtime_error("ERROR: Rounds number must be equal or greater than 2!!!\n");
+
+	Release();
+	SetRounds(dir, rounds, final ? rnum - 1 : rnum, final);
+}
+
+void CTableSet::Assign(direction_t dir, void const* tables, uint32_t rnum)
+{
+	if (!tables || rnum < 2)
+		throw std::runtime_error("ERROR: Rounds number must be equal or greater than 2!!!\n");
+
+	Release();
+	m_storage = alloc_aligned(rnum * sizeof(round_tbl_t));
+	memcpy(m_storage, tables, rnum * sizeof(round_tbl_t));
+
+	std::vector<round_ptr_t> rounds(rnum);
+	for (uint32_t i = 0; i < rnum; ++i)
+		rounds[i] = ((round_tbl_t const*)m_storage)[i];
+	SetRounds(dir, &rounds[0], rnum, 0);
+}
+
+void CTableSet::Load(char const* fname, bool verify)
+{
+	Release();
+	m_file.Open(fname);
+	try
+	{
+		AttachImage(m_file.Data(), m_file.Size(), verify);
+	}
+	catch (...)
+	{
+		m_file.Close();
+		throw;
+	}
+}
+
+void CTableSet::AttachImage(void const* image, size_t size, bool verify)
+{
+	uint8_t const* base = (uint8_t const*)image;
+	tbl_file_header_t const* h = (tbl_file_header_t const*)image;
+
+	if (!image || size < sizeof(tbl_file_header_t) || memcmp(h->magic, tbl_file_magic, sizeof(tbl_file_magic)))
+		throw std::runtime_error("ERROR: Not an EVHEN lookup tables file!!!\n");
+	if (h->version != tbl_file_version || h->header_size != sizeof(tbl_file_header_t))
+		throw std::runtime_error("ERROR: Unsupported version of lookup tables file!!!\n");
+	if (h->block_size != 16 || h->direction > wb_decryption || h->rounds_num < 2 ||
+		h->file_size != size || (uint64_t)h->rounds_num * sizeof(tbl_round_desc_t) > size - h->header_size)
+		throw std::runtime_error("ERROR: Lookup tables file is corrupted!!!\n");
+	if (verify && tbl_checksum(base + h->header_size, size - h->header_size) != h->checksum)
+		throw std::runtime_error("ERROR: Checksum of lookup tables file mismatch!!!\n");
+
+	// Only the last round may be stored as byte substitutions
+	tbl_round_desc_t const* desc = (tbl_round_desc_t const*)(base + h->header_size);
+	std::vector<round_ptr_t> rounds;
+	sbox_ptr_t final(0);
+	for (uint32_t i = 0; i < h->rounds_num; ++i)
+	{
+		bool sbox = (desc[i].kind == tbl_round_sbox && i == h->rounds_num - 1);
+		if ((!sbox && desc[i].kind != tbl_round_tboxes) ||
+			desc[i].size != (sbox ? sizeof(round_sbox_t) : sizeof(round_tbl_t)) ||
+			desc[i].offset % tbl_file_alignment || desc[i].offset > size || size - desc[i].offset < desc[i].size)
+			throw std::runtime_error("ERROR: Lookup tables file is corrupted!!!\n");
+		if (sbox)
+			final = *(round_sbox_t const*)(base + desc[i].offset);
+		else
+			rounds.push_back(*(round_tbl_t const*)(base + desc[i].offset));
+	}
+
+	// Keep the mapping if the image belongs to it
+	ReleaseTables();
+	if (image != m_file.Data())
+		m_file.Close();
+
+	SetRounds((direction_t)h->direction, &rounds[0], (uint32_t)rounds.size(), final);
+}
+
+void CTableSet::Expand(char const* fname, CThreadPool* pool, bool verify)
+{
+	// The key is needed only while the tables are built
+	CMappedFile file;
+	file.Open(fname);
+	ExpandImage(file.Data(), file.Size(), pool, verify);
+}
+
+void CTableSet::ExpandImage(void const* image, size_t size, CThreadPool* pool, bool verify)
+{
+	uint32_t rnum = check_key(image, size, verify);
+
+	Release();
+	m_storage = alloc_aligned((rnum - 1) * sizeof(round_tbl_t));
+	m_final_storage = alloc_aligned(sizeof(round_sbox_t));
+	expand_key(image, (round_tbl_t*)m_storage, *(round_sbox_t*)m_final_storage, pool);
+
+	std::vector<round_ptr_t> rounds(rnum - 1);
+	for (uint32_t i = 0; i < rnum - 1; ++i)
+		rounds[i] = ((round_tbl_t const*)m_storage)[i];
+	SetRounds((direction_t)((key_file_header_t const*)image)->direction, &rounds[0], rnum - 1,
+		*(round_sbox_t const*)m_final_storage);
+}
+
+void CTableSet::ReleaseTables()
+{
+	m_rounds.clear();
+	m_final = 0;
+	free_aligned(m_storage);
+	free_aligned(m_final_storage);
+	m_storage = 0;
+	m_final_storage = 0;
+}
+
+void CTableSet::Release()
+{
+	ReleaseTables();
+	m_file.Close();
+}
+
+}
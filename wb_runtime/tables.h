@@ -0,0 +1,172 @@
+//***************************************************************************************
+// tables.h
+// A set of EVHEN white-box lookup tables (public or private key) loaded at runtime
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+
+#ifndef TABLES_H
+#define TABLES_H
+
+#include "stdtypes.h"
+#include "mapfile.h"
+#include <stddef.h>
+#include <vector>
+
+namespace NWhiteBox
+{
+
+class CThreadPool;
+
+enum direction_t
+{
+	wb_encryption = 0,
+	wb_decryption = 1
+};
+
+// One round of T-boxes: 16 tables (one per input byte) of 256 entries
+typedef tbox_t		round_tbl_t[16][256];
+typedef tbox_t const	(*round_ptr_t)[256];
+
+// The last round has no mixes and no masks (its matrix is the identity), so only byte j of
+// an entry of table j is not zero. Such a round is stored as 16 byte substitutions.
+typedef uint8_t			round_sbox_t[16][256];
+typedef uint8_t const	(*sbox_ptr_t)[256];
+
+// Order in which a round reads the bytes of its input block:
+// encryption reads the state like ShiftRows, decryption like InvShiftRows
+static const uint8_t round_input_order[2][16] = {
+	{ 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 },
+	{ 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 }
+};
+
+inline bool is_sparse_round(round_ptr_t t)
+{
+	for (int j = 0; j < 16; ++j)
+	{
+		for (int k = 0; k < 256; ++k)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				if (i != j && t[j][k][i])
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+inline void compress_round(round_ptr_t t, round_sbox_t& s)
+{
+	for (int j = 0; j < 16; ++j)
+	{
+		for (int k = 0; k < 256; ++k)
+			s[j][k] = t[j][k][j];
+	}
+}
+
+class CTableSet
+{
+public:
+	CTableSet();
+	virtual ~CTableSet();
+
+public:
+	// Refers to tables owned by the caller (e.g. compiled in wb_encr_tbl.h). Nothing is copied.
+	// If final is given, it is the last round and rounds holds rnum - 1 rounds of T-boxes.
+	// Otherwise a sparse last round of T-boxes is compressed to a copy of 4 KB.
+	void Attach(direction_t dir, round_ptr_t const* rounds, uint32_t rnum, sbox_ptr_t final = 0);
+	// Copies rnum contiguous rounds of T-boxes into an own aligned storage
+	void Assign(direction_t dir, void const* tables, uint32_t rnum);
+	// Maps a binary file of wb_creator (see tblformat.h) read-only and uses the tables in place
+	void Load(char const* fname, bool verify = true);
+	// Uses an image of a binary file which is already in memory. Nothing is copied.
+	void AttachImage(void const* image, size_t size, bool verify = true);
+	// Builds the tables of a compact key of wb_creator (see keyformat.h) in an own storage
+	void Expand(char const* fname, CThreadPool* pool = 0, bool verify = true);
+	void ExpandImage(void const* image, size_t size, CThreadPool* pool = 0, bool verify = true);
+	void Release();
+
+public:
+	bool IsInit() const
+	{
+		return !m_rounds.empty();
+	}
+
+	direction_t Direction() const
+	{
+		return m_dir;
+	}
+
+	// All rounds including the final one
+	uint32_t RoundsNum() const
+	{
+		return (uint32_t)m_rounds.size() + (m_final ? 1 : 0);
+	}
+
+	// Rounds of T-boxes: all rounds or all but the final one
+	uint32_t TboxRoundsNum() const
+	{
+		return (uint32_t)m_rounds.size();
+	}
+
+	// Byte substitutions of the final round or 0
+	sbox_ptr_t FinalSbox() const
+	{
+		return m_final;
+	}
+
+	round_ptr_t Round(uint32_t i) const
+	{
+		return m_rounds[i];
+	}
+
+	round_ptr_t const* Rounds() const
+	{
+		return &m_rounds[0];
+	}
+
+	uint8_t const* InputOrder() const
+	{
+		return round_input_order[m_dir];
+	}
+
+private:
+	CTableSet(CTableSet const&);
+	CTableSet const& operator =(CTableSet const&);
+
+	void SetRounds(direction_t dir, round_ptr_t const* rounds, uint32_t rnum, sbox_ptr_t final);
+	void ReleaseTables();
+
+private:
+	direction_t					m_dir;
+	std::vector<round_ptr_t>	m_rounds;
+	sbox_ptr_t					m_final;
+	void*						m_storage;
+	void*						m_final_storage;
+	CMappedFile					m_file;
+};
+
+void* alloc_aligned(size_t size);	// 64-byte (cache line) aligned
+void free_aligned(void* p);
+
+}
+
+#endif // TABLES_H
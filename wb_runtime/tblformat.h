@@ -0,0 +1,107 @@
+//***************************************************************************************
+// tblformat.h
+// Binary format of EVHEN white-box lookup tables (*.bin files of wb_creator)
+//
+// Copyright  2016-2017 Dmitry Schelkunov. All rights reserved.
+// Contacts: <d.schelkunov@gmail.com>, <http://dschelkunov.blogspot.com/>
+//
+// This file is part of wb_runtime.
+//
+// wb_runtime is free software : you can redistribute it and / or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// wb_runtime is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with wb_runtime.If not, see <http://www.gnu.org/licenses/>.
+//
+//***************************************************************************************
+//
+// All fields are little-endian. A file is laid out as
+//
+//   tbl_file_header_t                       64 bytes
+//   tbl_round_desc_t[rounds_num]            16 bytes each, padded to 64 bytes
+//   round tables                            every one starts at a 64-byte boundary
+//
+// so a mapped file is used in place: a round descriptor holds the offset of its
+// tables from the beginning of the file. The checksum covers everything after the header.
+//
+//***************************************************************************************
+
+#ifndef TBLFORMAT_H
+#define TBLFORMAT_H
+
+#include "tables.h"
+#include <string.h>
+
+namespace NWhiteBox
+{
+
+static const char		tbl_file_magic[8] = { 'E', 'V', 'H', 'E', 'N', 'T', 'B', 'L' };
+const uint32_t			tbl_file_version = 1;
+const uint32_t			tbl_file_alignment = 64;
+
+enum tbl_round_kind_t
+{
+	tbl_round_tboxes = 0,		// round_tbl_t: 16 x 256 T-box entries
+	tbl_round_sbox = 1			// round_sbox_t: 16 x 256 byte substitutions (the last round only)
+};
+
+#pragma pack(push, 1)
+
+struct tbl_file_header_t
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;		// sizeof( tbl_file_header_t )
+	uint32_t	direction;			// direction_t
+	uint32_t	rounds_num;
+	uint32_t	block_size;			// 16
+	uint32_t	alignment;			// tbl_file_alignment
+	uint64_t	file_size;
+	uint64_t	data_offset;		// offset of the first round tables
+	uint64_t	checksum;			// tbl_checksum() of bytes [header_size, file_size)
+	uint8_t		reserved[8];
+};
+
+struct tbl_round_desc_t
+{
+	uint32_t	kind;				// tbl_round_kind_t
+	uint32_t	size;
+	uint64_t	offset;
+};
+
+#pragma pack(pop)
+
+inline uint64_t tbl_align(uint64_t size)
+{
+	return (size + tbl_file_alignment - 1) & ~(uint64_t)(tbl_file_alignment - 1);
+}
+
+// FNV-1a over 64-bit words (the tail is zero padded). Sizes in the file are multiples of 8 anyway.
+inline uint64_t tbl_checksum(void const* data, uint64_t size, uint64_t h = 0xcbf29ce484222325ULL)
+{
+	uint8_t const* p = (uint8_t const*)data;
+	for (; size >= 8; size -= 8, p += 8)
+	{
+		uint64_t w;
+		memcpy(&w, p, 8);
+		h = (h ^ w) * 0x100000001b3ULL;
+	}
+	if (size)
+	{
+		uint64_t w(0);
+		memcpy(&w, p, (size_t)size);
+		h = (h ^ w) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+}
+
+#endif // TBLFORMAT_H
@@ -22,173 +22,58 @@
 //
 //***************************************************************************************
 #include <stdio.h>
+#include <string.h>
+#include <stdexcept>
 #include "stdtypes.h"
+#include "engine.h"
+#include "cbc.h"
 #include "wb_decr_tbl.h"
 #include "wb_encr_tbl.h"
 
-
-#define encr_r( bo, bi, r ) do{                                                     \
-    ((uint32_t*)bo)[0] = ((uint32_t*)wb_encr_tbl_##r[0][((uint8_t*)bi)[0]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[1][((uint8_t*)bi)[5]])[0] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[2][((uint8_t*)bi)[10]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[3][((uint8_t*)bi)[15]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[4][((uint8_t*)bi)[4]])[0] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[5][((uint8_t*)bi)[9]])[0] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[6][((uint8_t*)bi)[14]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[7][((uint8_t*)bi)[3]])[0] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[8][((uint8_t*)bi)[8]])[0] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[9][((uint8_t*)bi)[13]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[10][((uint8_t*)bi)[2]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[11][((uint8_t*)bi)[7]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[12][((uint8_t*)bi)[12]])[0] ^   \
-                        ((uint32_t*)wb_encr_tbl_##r[13][((uint8_t*)bi)[1]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[14][((uint8_t*)bi)[6]])[0] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[15][((uint8_t*)bi)[11]])[0];    \
-    ((uint32_t*)bo)[1] = ((uint32_t*)wb_encr_tbl_##r[0][((uint8_t*)bi)[0]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[1][((uint8_t*)bi)[5]])[1] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[2][((uint8_t*)bi)[10]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[3][((uint8_t*)bi)[15]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[4][((uint8_t*)bi)[4]])[1] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[5][((uint8_t*)bi)[9]])[1] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[6][((uint8_t*)bi)[14]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[7][((uint8_t*)bi)[3]])[1] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[8][((uint8_t*)bi)[8]])[1] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[9][((uint8_t*)bi)[13]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[10][((uint8_t*)bi)[2]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[11][((uint8_t*)bi)[7]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[12][((uint8_t*)bi)[12]])[1] ^   \
-                        ((uint32_t*)wb_encr_tbl_##r[13][((uint8_t*)bi)[1]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[14][((uint8_t*)bi)[6]])[1] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[15][((uint8_t*)bi)[11]])[1];    \
-    ((uint32_t*)bo)[2] = ((uint32_t*)wb_encr_tbl_##r[0][((uint8_t*)bi)[0]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[1][((uint8_t*)bi)[5]])[2] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[2][((uint8_t*)bi)[10]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[3][((uint8_t*)bi)[15]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[4][((uint8_t*)bi)[4]])[2] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[5][((uint8_t*)bi)[9]])[2] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[6][((uint8_t*)bi)[14]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[7][((uint8_t*)bi)[3]])[2] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[8][((uint8_t*)bi)[8]])[2] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[9][((uint8_t*)bi)[13]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[10][((uint8_t*)bi)[2]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[11][((uint8_t*)bi)[7]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[12][((uint8_t*)bi)[12]])[2] ^   \
-                        ((uint32_t*)wb_encr_tbl_##r[13][((uint8_t*)bi)[1]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[14][((uint8_t*)bi)[6]])[2] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[15][((uint8_t*)bi)[11]])[2];    \
-    ((uint32_t*)bo)[3] = ((uint32_t*)wb_encr_tbl_##r[0][((uint8_t*)bi)[0]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[1][((uint8_t*)bi)[5]])[3] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[2][((uint8_t*)bi)[10]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[3][((uint8_t*)bi)[15]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[4][((uint8_t*)bi)[4]])[3] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[5][((uint8_t*)bi)[9]])[3] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[6][((uint8_t*)bi)[14]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[7][((uint8_t*)bi)[3]])[3] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[8][((uint8_t*)bi)[8]])[3] ^     \
-                        ((uint32_t*)wb_encr_tbl_##r[9][((uint8_t*)bi)[13]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[10][((uint8_t*)bi)[2]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[11][((uint8_t*)bi)[7]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[12][((uint8_t*)bi)[12]])[3] ^   \
-                        ((uint32_t*)wb_encr_tbl_##r[13][((uint8_t*)bi)[1]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[14][((uint8_t*)bi)[6]])[3] ^    \
-                        ((uint32_t*)wb_encr_tbl_##r[15][((uint8_t*)bi)[11]])[3]; } while( 0 );  
-                                                                                    
-#define decr_r( bo, bi, r )  do {                                                   \
-    ((uint32_t*)bo)[0] = ((uint32_t*)wb_decr_tbl_##r[0][((uint8_t*)bi)[0]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[1][((uint8_t*)bi)[13]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[2][((uint8_t*)bi)[10]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[3][((uint8_t*)bi)[7]])[0] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[4][((uint8_t*)bi)[4]])[0] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[5][((uint8_t*)bi)[1]])[0] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[6][((uint8_t*)bi)[14]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[7][((uint8_t*)bi)[11]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[8][((uint8_t*)bi)[8]])[0] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[9][((uint8_t*)bi)[5]])[0] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[10][((uint8_t*)bi)[2]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[11][((uint8_t*)bi)[15]])[0] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[12][((uint8_t*)bi)[12]])[0] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[13][((uint8_t*)bi)[9]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[14][((uint8_t*)bi)[6]])[0] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[15][((uint8_t*)bi)[3]])[0];     \
-    ((uint32_t*)bo)[1] = ((uint32_t*)wb_decr_tbl_##r[0][((uint8_t*)bi)[0]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[1][((uint8_t*)bi)[13]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[2][((uint8_t*)bi)[10]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[3][((uint8_t*)bi)[7]])[1] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[4][((uint8_t*)bi)[4]])[1] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[5][((uint8_t*)bi)[1]])[1] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[6][((uint8_t*)bi)[14]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[7][((uint8_t*)bi)[11]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[8][((uint8_t*)bi)[8]])[1] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[9][((uint8_t*)bi)[5]])[1] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[10][((uint8_t*)bi)[2]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[11][((uint8_t*)bi)[15]])[1] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[12][((uint8_t*)bi)[12]])[1] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[13][((uint8_t*)bi)[9]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[14][((uint8_t*)bi)[6]])[1] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[15][((uint8_t*)bi)[3]])[1];     \
-    ((uint32_t*)bo)[2] = ((uint32_t*)wb_decr_tbl_##r[0][((uint8_t*)bi)[0]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[1][((uint8_t*)bi)[13]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[2][((uint8_t*)bi)[10]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[3][((uint8_t*)bi)[7]])[2] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[4][((uint8_t*)bi)[4]])[2] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[5][((uint8_t*)bi)[1]])[2] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[6][((uint8_t*)bi)[14]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[7][((uint8_t*)bi)[11]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[8][((uint8_t*)bi)[8]])[2] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[9][((uint8_t*)bi)[5]])[2] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[10][((uint8_t*)bi)[2]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[11][((uint8_t*)bi)[15]])[2] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[12][((uint8_t*)bi)[12]])[2] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[13][((uint8_t*)bi)[9]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[14][((uint8_t*)bi)[6]])[2] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[15][((uint8_t*)bi)[3]])[2];     \
-    ((uint32_t*)bo)[3] = ((uint32_t*)wb_decr_tbl_##r[0][((uint8_t*)bi)[0]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[1][((uint8_t*)bi)[13]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[2][((uint8_t*)bi)[10]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[3][((uint8_t*)bi)[7]])[3] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[4][((uint8_t*)bi)[4]])[3] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[5][((uint8_t*)bi)[1]])[3] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[6][((uint8_t*)bi)[14]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[7][((uint8_t*)bi)[11]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[8][((uint8_t*)bi)[8]])[3] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[9][((uint8_t*)bi)[5]])[3] ^     \
-                        ((uint32_t*)wb_decr_tbl_##r[10][((uint8_t*)bi)[2]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[11][((uint8_t*)bi)[15]])[3] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[12][((uint8_t*)bi)[12]])[3] ^   \
-                        ((uint32_t*)wb_decr_tbl_##r[13][((uint8_t*)bi)[9]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[14][((uint8_t*)bi)[6]])[3] ^    \
-                        ((uint32_t*)wb_decr_tbl_##r[15][((uint8_t*)bi)[3]])[3]; } while( 0 );
-
-int main()
+int main( int argc, char* argv[] )
 {
     char bi[] = { 'W', 'h', 'i', 't', 'e', '-', 'B', 'o', 'x', ' ', 's', 'a', 'm', 'p', 'l', 'e', 0 };
     char bo[16];
+    // Whole blocks, the rest of the buffer is zero padding
+    char msg[80] = "CBC mode: the public key encrypts and only the private one decrypts";
+    uint8_t iv[16] = { 0 };
 
     printf_s( "Before: %s\n", bi );
 
-    encr_r( bo, bi, 0 );
-    encr_r( bi, bo, 1 );
-    encr_r( bo, bi, 2 );
-    encr_r( bi, bo, 3 );
-    encr_r( bo, bi, 4 );
-    encr_r( bi, bo, 5 );
-    encr_r( bo, bi, 6 );
-    encr_r( bi, bo, 7 );
-    encr_r( bo, bi, 8 );
-    encr_r( bi, bo, 9 );
+    try
+    {
+        NWhiteBox::CTableSet encr, decr;
+        if( argc == 3 )
+        {
+            // Keys from wb_creator binary files: wb_sample.exe wb_encr_tbl.bin wb_decr_tbl.bin
+            encr.Load( argv[1] );
+            decr.Load( argv[2] );
+        }
+        else
+        {
+            encr.Attach( NWhiteBox::wb_encryption, wb_encr_tbl, wb_encr_tbl_rnum, wb_encr_tbl_final );
+            decr.Attach( NWhiteBox::wb_decryption, wb_decr_tbl, wb_decr_tbl_rnum, wb_decr_tbl_final );
+        }
+
+        NWhiteBox::encrypt_block( encr, (uint8_t*)bi, (uint8_t*)bo );
+        NWhiteBox::decrypt_block( decr, (uint8_t*)bo, (uint8_t*)bi );
+
+        // CBC keeps the tables asymmetric. CTR would decrypt with the encryption tables too,
+        // so they would have to be kept secret (see ctr.h).
+        uint8_t iv_decr[16];
+        memcpy( iv_decr, iv, sizeof( iv ) );
+        NWhiteBox::cbc_encrypt( encr, iv, (uint8_t*)msg, (uint8_t*)msg, sizeof( msg ) / 16 );
+        NWhiteBox::cbc_decrypt( decr, iv_decr, (uint8_t*)msg, (uint8_t*)msg, sizeof( msg ) / 16 );
+    }
+    catch( std::runtime_error& e )
+    {
+        printf_s( "%s", e.what() );
+        getchar();
+        return 1;
+    }
 
-    decr_r( bo, bi, 0 );
-    decr_r( bi, bo, 1 );
-    decr_r( bo, bi, 2 );
-    decr_r( bi, bo, 3 );
-    decr_r( bo, bi, 4 );
-    decr_r( bi, bo, 5 );
-    decr_r( bo, bi, 6 );
-    decr_r( bi, bo, 7 );
-    decr_r( bo, bi, 8 );
-    decr_r( bi, bo, 9 ); 
-    
     printf_s( "After: %s\n", bi );
+    printf_s( "CBC: %s\n", msg );
 
 	getchar();
 